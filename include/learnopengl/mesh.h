@@ -7,6 +7,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <rg/Bounds.h>
+#include <rg/Lod.h>
+#include <rg/VertexPacking.h>
 
 #include <string>
 #include <vector>
@@ -41,65 +44,174 @@ public:
     vector<Texture>      textures;
 
     unsigned int VAO;
+    unsigned int indexCount = 0;
+    // index ranges of the levels of detail, level 0 is the full mesh
+    vector<rg::MeshLod> lods;
     std::string glslIdentifierPrefix;
+    // object-space AABB and bounding sphere, used for frustum culling
+    rg::Bounds bounds;
+    // layer of the owning Model's texture arrays, which the Model binds; -1 while the mesh
+    // binds its own textures
+    int textureLayer = -1;
+    // layout of the GPU vertex buffer; the CPU copy is always full Vertex
+    rg::VertexFormat format = rg::VertexFormat::Float;
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures,
+         rg::VertexFormat format = rg::VertexFormat::Float, vector<rg::MeshLod> lods = {}) : lods(std::move(lods)), format(format)
     {
-        this->vertices = vertices;
-        this->indices = indices;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
         this->textures = textures;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+    // uploads straight from memory the mesh doesn't own, e.g. a mapped rg::MeshCache file;
+    // no CPU copy of the vertices and indices is kept
+    Mesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount, vector<Texture> textures,
+         rg::VertexFormat format = rg::VertexFormat::Float, vector<rg::MeshLod> lods = {}) : lods(std::move(lods)), format(format)
     {
-        // bind appropriate textures
+        this->textures = textures;
+        setupMesh(vertices, vertexCount, indices, indexCount);
+    }
+
+    // render the mesh, lod is clamped to the coarsest level there is
+    void Draw(Shader &shader, unsigned int lod = 0)
+    {
+        const ProgramBindings &bindings = bindingsFor(shader);
+        bindTextures(shader, bindings);
+        setPositionDecode(shader, bindings);
+
+        // draw mesh
+        const rg::MeshLod &level = countLod(lod, 1);
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, level.count, GL_UNSIGNED_INT, (void*)(level.first * sizeof(unsigned int)));
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // render instanceCount copies of the mesh, the VAO needs an instance buffer attached
+    void DrawInstanced(Shader &shader, GLsizei instanceCount, unsigned int lod = 0)
+    {
+        const ProgramBindings &bindings = bindingsFor(shader);
+        bindTextures(shader, bindings);
+        setPositionDecode(shader, bindings);
+
+        const rg::MeshLod &level = countLod(lod, instanceCount);
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, level.count, GL_UNSIGNED_INT, (void*)(level.first * sizeof(unsigned int)), instanceCount);
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    // render data
+    unsigned int VBO, EBO;
+    // maps packed positions back to object space, see rg::PackedVertex
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+
+    const rg::MeshLod& countLod(unsigned int lod, GLsizei instanceCount) const
+    {
+        const rg::MeshLod &level = lods[std::min<size_t>(lod, lods.size() - 1)];
+        rg::LodSelector::frameStats().triangles += static_cast<unsigned long>(level.count / 3) * instanceCount;
+        rg::LodSelector::frameStats().fullTriangles += static_cast<unsigned long>(lods[0].count / 3) * instanceCount;
+        return level;
+    }
+
+    // sampler uniform and texture unit of every texture, and the position decode uniforms,
+    // resolved once per shader program the mesh is drawn with
+    struct ProgramBindings {
+        GLuint program;
+        vector<GLint> samplers; // location per texture, the unit is its index
+        GLint positionOffset;
+        GLint positionScale;
+    };
+    vector<ProgramBindings> programBindings;
+    // glslIdentifierPrefix + type + N of every texture, for the prefix they were made with
+    vector<string> samplerNames;
+    string samplerNamePrefix;
+
+    const ProgramBindings& bindingsFor(const Shader &shader)
+    {
+        if (samplerNames.size() != textures.size() || samplerNamePrefix != glslIdentifierPrefix) {
+            buildSamplerNames();
+            programBindings.clear();
+        }
+        for (const ProgramBindings &bindings : programBindings)
+            if (bindings.program == shader.ID)
+                return bindings;
+
+        ProgramBindings bindings;
+        bindings.program = shader.ID;
+        for (const string &name : samplerNames)
+            bindings.samplers.push_back(shader.uniformLocation(name));
+        bindings.positionOffset = shader.uniformLocation("positionOffset");
+        bindings.positionScale = shader.uniformLocation("positionScale");
+        programBindings.push_back(std::move(bindings));
+        return programBindings.back();
+    }
+
+    void buildSamplerNames()
+    {
+        // the N in diffuse_textureN counts the textures of each type
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
+        samplerNames.clear();
+        for (const Texture &texture : textures) {
             string number;
-            string name = textures[i].type;
+            const string &name = texture.type;
             if(name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
             else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
+                number = std::to_string(specularNr++);
             else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
+                number = std::to_string(normalNr++);
             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+                number = std::to_string(heightNr++);
+            samplerNames.push_back(glslIdentifierPrefix + name + number);
         }
+        samplerNamePrefix = glslIdentifierPrefix;
+    }
 
-
-
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    void setPositionDecode(Shader &shader, const ProgramBindings &bindings)
+    {
+        if (format != rg::VertexFormat::Packed)
+            return;
+        shader.setVec3(bindings.positionOffset, positionOffset);
+        shader.setVec3(bindings.positionScale, positionScale);
     }
 
-private:
-    // render data
-    unsigned int VBO, EBO;
+    void bindTextures(Shader &shader, const ProgramBindings &bindings)
+    {
+        if (textureLayer >= 0)
+            return;
+        for (unsigned int i = 0; i < textures.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            shader.setInt(bindings.samplers[i], i);
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+    }
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    // indices holds all levels back to back, without a level table it is a single level
+    void setupMesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount)
     {
+        this->indexCount = static_cast<unsigned int>(indexCount);
+        if (lods.empty()) {
+            lods.resize(1);
+            lods[0].count = this->indexCount;
+        }
+        // Vertex is made of floats only, so positions can be read with a float stride
+        if (vertexCount)
+            bounds = rg::Bounds::fromPositions(&vertices[0].Position.x, vertexCount, sizeof(Vertex) / sizeof(float));
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -108,13 +220,19 @@ private:
         glBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+
+        if (format == rg::VertexFormat::Packed) {
+            setupPacked(vertices, vertexCount);
+            glBindVertexArray(0);
+            return;
+        }
+
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -135,5 +253,34 @@ private:
 
         glBindVertexArray(0);
     }
+
+    // quantizes against the mesh AABB and uploads rg::PackedVertex, with the VAO and
+    // GL_ARRAY_BUFFER bound
+    void setupPacked(const Vertex *vertices, size_t vertexCount)
+    {
+        if (vertexCount) {
+            positionOffset = bounds.min;
+            positionScale = bounds.max - bounds.min;
+        }
+        vector<rg::PackedVertex> packed(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            const Vertex &v = vertices[i];
+            packed[i] = rg::packing::pack(v.Position, v.Normal, v.TexCoords, v.Tangent, v.Bitangent, positionOffset, positionScale);
+        }
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(rg::PackedVertex), packed.data(), GL_STATIC_DRAW);
+
+        // position and handedness
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(rg::PackedVertex), (void*)offsetof(rg::PackedVertex, position));
+        // octahedral normal
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(rg::PackedVertex), (void*)offsetof(rg::PackedVertex, normal));
+        // texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(rg::PackedVertex), (void*)offsetof(rg::PackedVertex, texCoords));
+        // octahedral tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(rg::PackedVertex), (void*)offsetof(rg::PackedVertex, tangent));
+    }
 };
 #endif
\ No newline at end of file
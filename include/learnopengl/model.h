@@ -12,7 +12,18 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
-
+#include <rg/AllocationCounter.h>
+#include <rg/Frustum.h>
+#include <rg/InstanceBuffer.h>
+#include <rg/Lod.h>
+#include <rg/TextureCache.h>
+#include <rg/MeshCache.h>
+#include <rg/ThreadPool.h>
+#include <rg/MeshOptimizer.h>
+#include <rg/MeshSimplifier.h>
+
+#include <algorithm>
+#include <future>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -29,22 +40,126 @@ class Model
 {
 public:
     // model data
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Texture> textures_loaded;	// every texture reference taken from rg::TextureCache, released with the model
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // GPU vertex layout of every mesh, Packed needs shaders compiled with PACKED_VERTEX
+    rg::VertexFormat vertexFormat;
+    // union of the mesh bounds
+    rg::Bounds bounds;
+    // object-space error of every level of detail, the largest over the meshes
+    vector<float> lodErrors;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, rg::VertexFormat format = rg::VertexFormat::Float)
+        : gammaCorrection(gamma), vertexFormat(format)
     {
         loadModel(path);
     }
 
+    ~Model()
+    {
+        for (const Texture &texture : textures_loaded)
+            rg::TextureCache::instance().release(texture.id);
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
-        for(unsigned int i = 0; i < meshes.size(); i++)
+        rg::AllocationCounter::Scope counted;
+        GLint layerLocation = bindTextureArrays(shader);
+        int layer = -1;
+        for(unsigned int i = 0; i < meshes.size(); i++) {
+            selectLayer(shader, layerLocation, meshes[i], layer);
             meshes[i].Draw(shader);
+        }
+    }
+
+    // draws only the meshes whose bounding sphere intersects the frustum, at the level of
+    // detail lods picks for the whole model or at full detail without one
+    void Draw(Shader &shader, const rg::Frustum &frustum, const glm::mat4 &model, const rg::LodSelector *lods = nullptr)
+    {
+        rg::AllocationCounter::Scope counted;
+        unsigned int lod = lods ? selectLod(*lods, model) : 0;
+        GLint layerLocation = bindTextureArrays(shader);
+        int layer = -1;
+        for(unsigned int i = 0; i < meshes.size(); i++) {
+            if (frustum.intersects(meshes[i].bounds.worldSphere(model))) {
+                rg::Frustum::frameStats().drawn++;
+                selectLayer(shader, layerLocation, meshes[i], layer);
+                meshes[i].Draw(shader, lod);
+            } else {
+                rg::Frustum::frameStats().culled++;
+            }
+        }
+    }
+
+    // draws instanceCount copies of every mesh, see rg::InstanceBuffer
+    void DrawInstanced(Shader &shader, GLsizei instanceCount)
+    {
+        rg::AllocationCounter::Scope counted;
+        GLint layerLocation = bindTextureArrays(shader);
+        int layer = -1;
+        for(unsigned int i = 0; i < meshes.size(); i++) {
+            selectLayer(shader, layerLocation, meshes[i], layer);
+            meshes[i].DrawInstanced(shader, instanceCount);
+        }
+    }
+
+    unsigned int selectLod(const rg::LodSelector &lods, const glm::mat4 &model) const
+    {
+        return lods.select(lodErrors, bounds.worldSphere(model), bounds.radius);
+    }
+
+    // Orders instance matrices by level of detail for the DrawInstanced below: sorted gets
+    // the matrices grouped by level, finest first, and lodCounts[l] the size of group l.
+    // Runs every frame, so all of its arrays are reused and stop allocating once grown.
+    void sortInstancesByLod(const rg::LodSelector &lods, const glm::mat4 *worlds, size_t count,
+                            vector<glm::mat4> &sorted, vector<GLsizei> &lodCounts)
+    {
+        lodCounts.assign(std::max<size_t>(lodErrors.size(), 1), 0);
+        instanceLevels.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            instanceLevels[i] = selectLod(lods, worlds[i]);
+            lodCounts[instanceLevels[i]]++;
+        }
+        levelStarts.assign(lodCounts.size(), 0);
+        for (size_t l = 1; l < levelStarts.size(); l++)
+            levelStarts[l] = levelStarts[l - 1] + lodCounts[l - 1];
+        sorted.resize(count);
+        for (size_t i = 0; i < count; i++)
+            sorted[levelStarts[instanceLevels[i]]++] = worlds[i];
+    }
+
+    // Draws the instances of a buffer filled from sortInstancesByLod, one instanced draw per
+    // mesh and level. GL 3.3 has no base instance, so the instance attributes are pointed
+    // at each level's range of the buffer instead.
+    void DrawInstanced(Shader &shader, const rg::InstanceBuffer &instances, const vector<GLsizei> &lodCounts)
+    {
+        rg::AllocationCounter::Scope counted;
+        GLsizei first = 0, attachedAt = 0;
+        GLint layerLocation = bindTextureArrays(shader);
+        int layer = -1;
+        for (unsigned int lod = 0; lod < lodCounts.size(); lod++) {
+            if (lodCounts[lod] == 0)
+                continue;
+            for (Mesh &mesh : meshes) {
+                if (first != attachedAt)
+                    instances.attach(mesh.VAO, first);
+                selectLayer(shader, layerLocation, mesh, layer);
+                mesh.DrawInstanced(shader, lodCounts[lod], lod);
+            }
+            attachedAt = first;
+            first += lodCounts[lod];
+        }
+        // leave the VAOs reading from the start for the plain DrawInstanced
+        if (attachedAt != 0)
+            for (Mesh &mesh : meshes)
+                instances.attach(mesh.VAO);
     }
 
     void SetShaderTextureNamePrefix(std::string prefix) {
@@ -52,116 +167,318 @@ public:
             mesh.glslIdentifierPrefix = prefix;
         }
     }
+
+    // Moves the material textures into one GL_TEXTURE_2D_ARRAY per texture type, a layer per
+    // distinct material, so the meshes draw with the arrays bound once per model and only a
+    // materialLayer uniform between them. Shaders then need TEXTURE_ARRAYS. Works when every
+    // mesh has one texture of each type and the images of a type are all the same size;
+    // returns false and leaves the model as it was otherwise.
+    bool useTextureArrays()
+    {
+        if (meshes.empty() || !textureArrays.empty())
+            return !textureArrays.empty();
+        const vector<Texture> &reference = meshes[0].textures;
+        vector<vector<string>> materials; // texture paths per layer, in the order of reference
+        vector<int> layers;
+        for (const Mesh &mesh : meshes) {
+            if (mesh.textures.size() != reference.size() || reference.empty())
+                return false;
+            vector<string> paths;
+            for (size_t t = 0; t < reference.size(); t++) {
+                if (mesh.textures[t].type != reference[t].type)
+                    return false;
+                paths.push_back(directory + '/' + mesh.textures[t].path);
+            }
+            auto found = std::find(materials.begin(), materials.end(), paths);
+            layers.push_back(static_cast<int>(found - materials.begin()));
+            if (found == materials.end())
+                materials.push_back(paths);
+        }
+
+        // a layer per material in every array, so the sizes have to agree type by type
+        for (size_t t = 0; t < reference.size(); t++) {
+            int width = 0, height = 0, components = 0;
+            for (const vector<string> &material : materials) {
+                int w, h;
+                if (!stbi_info(material[t].c_str(), &w, &h, &components) || (width && (w != width || h != height)))
+                    return false;
+                width = w;
+                height = h;
+            }
+        }
+
+        for (size_t t = 0; t < reference.size(); t++) {
+            vector<string> files;
+            for (const vector<string> &material : materials)
+                files.push_back(material[t]);
+            Texture array;
+            array.id = rg::TextureCache::instance().acquireArray(files);
+            array.type = reference[t].type;
+            array.path = files[0];
+            textureArrays.push_back(array);
+        }
+        for (const Texture &texture : textures_loaded)
+            rg::TextureCache::instance().release(texture.id);
+        textures_loaded = textureArrays;
+
+        // the arrays keep the texture units the single textures had
+        for (size_t i = 0; i < meshes.size(); i++) {
+            meshes[i].textures = textureArrays;
+            meshes[i].textureLayer = layers[i];
+        }
+        // meshes of one material next to each other, for fewer layer changes
+        std::stable_sort(meshes.begin(), meshes.end(), [](const Mesh &a, const Mesh &b) { return a.textureLayer < b.textureLayer; });
+        return true;
+    }
+
 private:
+    // one per texture type once useTextureArrays succeeded, in the meshes' texture order
+    vector<Texture> textureArrays;
+    // sortInstancesByLod scratch: level of every instance, next slot of every level
+    vector<unsigned int> instanceLevels;
+    vector<GLsizei> levelStarts;
+
+    // sampler locations of the texture arrays and of materialLayer, resolved once per program
+    struct ArrayBindings {
+        GLuint program;
+        vector<GLint> samplers;
+        GLint materialLayer;
+    };
+    vector<ArrayBindings> arrayBindings;
+
+    // binds the texture arrays to units 0, 1, ... and points the samplers at them; returns
+    // the location of materialLayer, -1 without arrays
+    GLint bindTextureArrays(Shader &shader)
+    {
+        if (textureArrays.empty())
+            return -1;
+        const ArrayBindings &bindings = arrayBindingsFor(shader);
+        for (unsigned int i = 0; i < textureArrays.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, textureArrays[i].id);
+            shader.setInt(bindings.samplers[i], i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        return bindings.materialLayer;
+    }
+
+    const ArrayBindings& arrayBindingsFor(const Shader &shader)
+    {
+        for (const ArrayBindings &bindings : arrayBindings)
+            if (bindings.program == shader.ID)
+                return bindings;
+        ArrayBindings bindings;
+        bindings.program = shader.ID;
+        for (const Texture &array : textureArrays)
+            bindings.samplers.push_back(shader.uniformLocation(meshes[0].glslIdentifierPrefix + array.type + "1"));
+        bindings.materialLayer = shader.uniformLocation("materialLayer");
+        arrayBindings.push_back(std::move(bindings));
+        return arrayBindings.back();
+    }
+
+    // current is the layer last selected, -1 for none yet
+    void selectLayer(Shader &shader, GLint location, const Mesh &mesh, int &current)
+    {
+        if (mesh.textureLayer < 0 || mesh.textureLayer == current)
+            return;
+        shader.setInt(location, mesh.textureLayer);
+        current = mesh.textureLayer;
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    // The processed meshes are cooked into an rg::MeshCache next to the file, later loads map that instead.
     void loadModel(string const &path)
     {
+        const unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        const std::uint64_t cacheKey = rg::MeshCache::key(path, importFlags);
+        if (loadCooked(path, cacheKey))
+            return;
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, importFlags);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        vector<aiMesh*> sceneMeshes;
+        processNode(scene->mRootNode, scene, sceneMeshes);
+        rg::meshopt::Report report = processMeshes(sceneMeshes, scene);
+        cout << path << ": " << meshes.size() << " meshes, " << report.triangles << " triangles, vertices "
+             << report.verticesBefore << " -> " << report.verticesAfter << ", ACMR "
+             << report.acmrBefore << " -> " << report.acmrAfter << endl;
+
+        collectBounds();
+
+        if (!rg::MeshCache::write(path, cacheKey, meshes))
+            cout << "could not write mesh cache " << rg::MeshCache::cachePath(path) << endl;
+    }
+
+    // uploads the meshes of an up to date cache straight from the mapped file
+    bool loadCooked(string const &path, std::uint64_t cacheKey)
+    {
+        rg::MeshCache cache;
+        if (!cache.open(path, cacheKey))
+            return false;
+
+        for (const rg::MeshCache::CookedMesh &cooked : cache.meshes()) {
+            vector<Texture> textures;
+            for (const rg::MeshCache::TextureRef &texture : cooked.textures)
+                textures.push_back(loadTexture(texture.path, texture.type));
+            meshes.push_back(Mesh(cooked.vertices, cooked.vertexCount, cooked.indices, cooked.indexCount, textures, vertexFormat, cooked.lods));
+        }
+        collectBounds();
+        return true;
+    }
+
+    // model bounds and level of detail errors from those of the meshes
+    void collectBounds()
+    {
+        lodErrors.clear();
+        for (const Mesh &mesh : meshes) {
+            bounds.merge(mesh.bounds);
+            if (mesh.lods.size() > lodErrors.size())
+                lodErrors.resize(mesh.lods.size(), 0.0f);
+        }
+        // a mesh with fewer levels draws its coarsest one for the levels it lacks
+        for (const Mesh &mesh : meshes)
+            for (size_t l = 0; l < lodErrors.size(); l++)
+                lodErrors[l] = std::max(lodErrors[l], mesh.lods[std::min(l, mesh.lods.size() - 1)].error);
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    // processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode(aiNode *node, const aiScene *scene, vector<aiMesh*> &sceneMeshes)
     {
-        // process each mesh located at the current node
+        // collect each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene.
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+        // after we've collected all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, sceneMeshes);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
-    {
-        // data to fill
+    static const unsigned int LOD_LEVELS = 4;
+
+    // vertex and index arrays of one mesh, converted off the GL thread
+    struct MeshData {
         vector<Vertex> vertices;
         vector<unsigned int> indices;
-        vector<Texture> textures;
+        vector<rg::MeshLod> lods;
+        rg::meshopt::Report report;
+    };
+
+    // Converts and optimizes the meshes on a thread pool, one job per mesh. Textures and GL
+    // buffers are created here on the calling thread, in the original mesh order, as the
+    // conversions finish. Returns the optimization totals of all meshes, ACMR triangle weighted.
+    rg::meshopt::Report processMeshes(const vector<aiMesh*> &sceneMeshes, const aiScene *scene)
+    {
+        unsigned int threads = std::min<unsigned int>(rg::ThreadPool::defaultThreadCount(), sceneMeshes.size());
+        rg::ThreadPool pool(std::max(1u, threads));
+        vector<std::future<MeshData>> converted;
+        for (const aiMesh *mesh : sceneMeshes)
+            converted.push_back(pool.submit([mesh]() { return convertMesh(mesh); }));
+
+        rg::meshopt::Report total;
+        meshes.reserve(meshes.size() + sceneMeshes.size());
+        for (unsigned int i = 0; i < sceneMeshes.size(); i++) {
+            vector<Texture> textures = processMaterial(scene->mMaterials[sceneMeshes[i]->mMaterialIndex]);
+            MeshData data = converted[i].get();
+            meshes.push_back(Mesh(std::move(data.vertices), std::move(data.indices), textures, vertexFormat, std::move(data.lods)));
+
+            total.verticesBefore += data.report.verticesBefore;
+            total.verticesAfter += data.report.verticesAfter;
+            total.triangles += data.report.triangles;
+            total.acmrBefore += data.report.acmrBefore * data.report.triangles;
+            total.acmrAfter += data.report.acmrAfter * data.report.triangles;
+        }
+        if (total.triangles) {
+            total.acmrBefore /= total.triangles;
+            total.acmrAfter /= total.triangles;
+        }
+        return total;
+    }
+
+    static MeshData convertMesh(const aiMesh *mesh)
+    {
+        // data to fill, sized up front
+        MeshData data;
+        data.vertices.resize(mesh->mNumVertices);
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
-            glm::vec3 vector; // we declare a placeholder vector since assimp_ uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-            // positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+            Vertex &vertex = data.vertices[i];
+            // positions, assimp_ uses its own vector class that doesn't directly convert to glm's vec3 class
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
             // normals
             if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
-            }
+                vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
             // texture coordinates
             if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
             {
-                glm::vec2 vec;
                 // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
                 // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
                 // tangent
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
+                vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
                 // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
+                vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
             }
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
-
-
         }
-        // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+
+        // now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        size_t indexCount = 0;
+        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+            indexCount += mesh->mFaces[i].mNumIndices;
+        data.indices.resize(indexCount);
+        size_t next = 0;
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+                data.indices[next++] = face.mIndices[j];
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+
+        // weld, then reorder for the post-transform cache, overdraw and fetch locality; the
+        // passes work on triangle lists only
+        if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE || data.vertices.empty())
+            return data;
+        data.report = rg::meshopt::optimize(data.vertices, data.indices, offsetof(Vertex, Position));
+
+        // coarser levels appended to the index buffer, none allowed to stray further than a
+        // twentieth of the mesh size from the full surface
+        rg::Bounds extent = rg::Bounds::fromPositions(&data.vertices[0].Position.x, data.vertices.size(), sizeof(Vertex) / sizeof(float));
+        data.lods = rg::meshopt::buildLods(data.indices, &data.vertices[0].Position.x, data.vertices.size(), sizeof(Vertex) / sizeof(float),
+                                           LOD_LEVELS, 0.05f * glm::length(extent.max - extent.min));
+        return data;
+    }
+
+    vector<Texture> processMaterial(aiMaterial *material)
+    {
+        vector<Texture> textures;
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
         // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER.
         // Same applies to other texture as the following list summarizes:
         // diffuse: texture_diffuseN
         // specular: texture_specularN
         // normal: texture_normalN
-        aiColor3D color(0.0f, 0.0f, 0.0f);
-        material->Get(AI_MATKEY_COLOR_AMBIENT, color);
-
 
         // 1. diffuse maps
         vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
@@ -176,10 +493,7 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-
-
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return textures;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -191,29 +505,22 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // loads the texture at path, relative to the model; rg::TextureCache shares it with every
+    // other user of the file and the model holds one reference per call until it is destroyed
+    Texture loadTexture(const string &path, const string &typeName)
+    {
+        Texture texture;
+        texture.id = TextureFromFile(path.c_str(), this->directory);
+        texture.type = typeName;
+        texture.path = path;
+        textures_loaded.push_back(texture);
+        return texture;
+    }
 };
 
 
@@ -222,38 +529,8 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    // decoded on the texture loader's threads, uploaded by TextureLoader::poll; the caller
+    // holds a reference in rg::TextureCache until it releases the texture
+    return rg::TextureCache::instance().acquire2D(filename);
 }
 #endif
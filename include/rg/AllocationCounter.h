@@ -0,0 +1,99 @@
+#ifndef PROJECT_BASE_ALLOCATIONCOUNTER_H
+#define PROJECT_BASE_ALLOCATIONCOUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace rg {
+
+// Per-frame heap allocation counters. drawAllocations are the ones the render thread made
+// inside an AllocationCounter::Scope, i.e. while drawing models.
+struct AllocationStats {
+    unsigned long allocations = 0;
+    unsigned long bytes = 0;
+    unsigned long drawAllocations = 0;
+};
+
+// Counts heap allocations through the replacement of the global operator new in
+// src/AllocationCounter.cpp; programs built without that file leave the counters at zero.
+class AllocationCounter {
+public:
+    static AllocationStats frameStats()
+    {
+        AllocationStats stats;
+        stats.allocations = counters().allocations.load(std::memory_order_relaxed);
+        stats.bytes = counters().bytes.load(std::memory_order_relaxed);
+        stats.drawAllocations = counters().drawAllocations.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    static AllocationStats endFrame()
+    {
+        AllocationStats last;
+        last.allocations = counters().allocations.exchange(0, std::memory_order_relaxed);
+        last.bytes = counters().bytes.exchange(0, std::memory_order_relaxed);
+        last.drawAllocations = counters().drawAllocations.exchange(0, std::memory_order_relaxed);
+        return last;
+    }
+
+    // called by the replacement operator new
+    static void count(std::size_t bytes)
+    {
+        counters().allocations.fetch_add(1, std::memory_order_relaxed);
+        counters().bytes.fetch_add(bytes, std::memory_order_relaxed);
+        threadAllocations()++;
+    }
+
+    // adds the allocations this thread makes while it is alive to drawAllocations; nested
+    // scopes count once
+    class Scope {
+    public:
+        Scope()
+            : m_start(threadAllocations())
+        {
+            depth()++;
+        }
+
+        ~Scope()
+        {
+            if (--depth() == 0)
+                counters().drawAllocations.fetch_add(threadAllocations() - m_start, std::memory_order_relaxed);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        unsigned long m_start;
+
+        static unsigned int& depth()
+        {
+            static thread_local unsigned int value = 0;
+            return value;
+        }
+    };
+
+private:
+    struct Counters {
+        std::atomic<unsigned long> allocations{ 0 };
+        std::atomic<unsigned long> bytes{ 0 };
+        std::atomic<unsigned long> drawAllocations{ 0 };
+    };
+
+    // constant initialized, so safe to use from allocations made before main
+    static Counters& counters()
+    {
+        static Counters value;
+        return value;
+    }
+
+    static unsigned long& threadAllocations()
+    {
+        static thread_local unsigned long value = 0;
+        return value;
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_ALLOCATIONCOUNTER_H
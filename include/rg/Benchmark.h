@@ -0,0 +1,159 @@
+#ifndef PROJECT_BASE_BENCHMARK_H
+#define PROJECT_BASE_BENCHMARK_H
+
+#include <learnopengl/camera.h>
+#include <rg/GLCallCounter.h>
+#include <rg/RenderState.h>
+#include <rg/Profiler.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Reproducible, non-interactive run: a fixed camera path over a fixed number of
+// frames, summarized in a JSON report.
+//
+//     ./projekat --bench [--frames N] [--warmup N] [--report bench.json]
+class Benchmark {
+public:
+    struct Options {
+        bool enabled = false;
+        unsigned int frames = 600;
+        unsigned int warmup = 30; // frames rendered before measuring, not reported
+        std::string report = "bench.json";
+    };
+
+    static Options parse(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--bench") == 0)
+                options.enabled = true;
+            else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+                options.frames = std::max(1, std::atoi(argv[++i]));
+            else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+                options.warmup = std::max(0, std::atoi(argv[++i]));
+            else if (std::strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+                options.report = argv[++i];
+        }
+        return options;
+    }
+
+    // the fixed time step the scene is advanced by in benchmark mode
+    static constexpr float DELTA_TIME = 1.0f / 60.0f;
+
+    explicit Benchmark(const Options &options)
+        : m_options(options)
+    {}
+
+    unsigned int frame() const { return m_frame; }
+    bool measuring() const { return m_frame >= m_options.warmup; }
+    bool finished() const { return m_frame >= m_options.warmup + m_options.frames; }
+
+    // one orbit around the table over the measured frames, bobbing up and down; warm-up
+    // frames hold the start pose
+    void placeCamera(Camera &camera) const
+    {
+        const float pi = 3.14159265f;
+        float t = measuring() ? static_cast<float>(m_frame - m_options.warmup) / m_options.frames : 0.0f;
+        float angle = 2.0f * pi * t;
+        camera.Position = glm::vec3(18.0f * std::cos(angle), 8.0f + 3.0f * std::sin(2.0f * angle), 18.0f * std::sin(angle));
+        camera.LookAt(glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    void beginFrame()
+    {
+        m_frameStart = std::chrono::steady_clock::now();
+    }
+
+    // call after the buffer swap, with the GL call counts of the frame
+    void endFrame(const GLCallStats &calls, const RenderStateStats &state)
+    {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_frameStart;
+        if (measuring()) {
+            m_cpuFrameTimes.push_back(elapsed.count());
+            m_drawCalls.push_back(calls.drawCalls);
+            m_stateChanges.push_back(calls.stateChanges);
+            m_elidedStateChanges.push_back(state.elided);
+        }
+        m_frame++;
+    }
+
+    bool writeReport(const Profiler &profiler, int width, int height) const
+    {
+        std::ofstream file(m_options.report);
+        if (!file)
+            return false;
+
+        file << "{\n";
+        file << "  \"frames\": " << m_cpuFrameTimes.size() << ",\n";
+        file << "  \"warmup\": " << m_options.warmup << ",\n";
+        file << "  \"width\": " << width << ",\n";
+        file << "  \"height\": " << height << ",\n";
+        file << "  \"cpu_frame_ms\": ";
+        writeStats(file, timingStats(m_cpuFrameTimes));
+        file << ",\n";
+
+        std::vector<std::string> passes = profiler.passes();
+        file << "  \"gpu_pass_ms\": {";
+        for (std::size_t i = 0; i < passes.size(); i++) {
+            file << (i ? ",\n" : "\n") << "    \"" << passes[i] << "\": ";
+            writeStats(file, profiler.gpuStats(passes[i]));
+        }
+        file << "\n  },\n";
+        file << "  \"cpu_pass_ms\": {";
+        for (std::size_t i = 0; i < passes.size(); i++) {
+            file << (i ? ",\n" : "\n") << "    \"" << passes[i] << "\": ";
+            writeStats(file, profiler.cpuStats(passes[i]));
+        }
+        file << "\n  },\n";
+
+        file << "  \"draw_calls\": ";
+        writeCounts(file, m_drawCalls);
+        file << ",\n";
+        file << "  \"state_changes\": ";
+        writeCounts(file, m_stateChanges);
+        file << ",\n";
+        file << "  \"elided_state_changes\": ";
+        writeCounts(file, m_elidedStateChanges);
+        file << "\n}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    Options m_options;
+    unsigned int m_frame = 0;
+    std::chrono::steady_clock::time_point m_frameStart;
+    std::vector<float> m_cpuFrameTimes;
+    std::vector<unsigned int> m_drawCalls;
+    std::vector<unsigned int> m_stateChanges;
+    std::vector<unsigned int> m_elidedStateChanges;
+
+    static void writeStats(std::ostream &out, const TimingStats &stats)
+    {
+        out << "{ \"min\": " << stats.min << ", \"avg\": " << stats.avg << ", \"p99\": " << stats.p99 << " }";
+    }
+
+    static void writeCounts(std::ostream &out, const std::vector<unsigned int> &counts)
+    {
+        unsigned long long sum = 0;
+        unsigned int min = counts.empty() ? 0 : counts[0], max = 0;
+        for (unsigned int count : counts) {
+            sum += count;
+            min = std::min(min, count);
+            max = std::max(max, count);
+        }
+        double avg = counts.empty() ? 0.0 : static_cast<double>(sum) / counts.size();
+        out << "{ \"min\": " << min << ", \"avg\": " << avg << ", \"max\": " << max << " }";
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_BENCHMARK_H
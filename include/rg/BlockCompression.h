@@ -0,0 +1,206 @@
+#ifndef PROJECT_BASE_BLOCKCOMPRESSION_H
+#define PROJECT_BASE_BLOCKCOMPRESSION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace rg {
+
+// CPU encoders for the BC1, BC3, BC4 and BC5 block formats. Endpoints are the inset bounding
+// box of the block's colors and every texel takes the nearest palette entry: fast and
+// deterministic, if a little below what an exhaustive search reaches.
+namespace bc {
+
+// 4x4 texels, RGBA8, row by row
+struct Block {
+    unsigned char texels[16][4];
+};
+
+// Copies the block at (bx, by) out of an RGBA8 image, repeating the last row and column
+// for blocks that hang over the edge.
+inline Block fetchBlock(const unsigned char *rgba, int width, int height, int bx, int by)
+{
+    Block block;
+    for (int y = 0; y < 4; y++) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            const unsigned char *texel = rgba + (static_cast<std::size_t>(sy) * width + sx) * 4;
+            std::copy(texel, texel + 4, block.texels[y * 4 + x]);
+        }
+    }
+    return block;
+}
+
+inline std::uint16_t to565(const int color[3])
+{
+    return static_cast<std::uint16_t>(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+inline void from565(std::uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// 8 bytes: two 565 endpoints and 2-bit indices, always in the four color mode
+inline void encodeColor(const Block &block, unsigned char *out)
+{
+    int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+    for (const auto &texel : block.texels)
+        for (int c = 0; c < 3; c++) {
+            lo[c] = std::min(lo[c], static_cast<int>(texel[c]));
+            hi[c] = std::max(hi[c], static_cast<int>(texel[c]));
+        }
+    // pull the endpoints in a little, the box corners are rarely the best fit
+    for (int c = 0; c < 3; c++) {
+        int inset = (hi[c] - lo[c]) / 16;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    std::uint16_t c0 = to565(hi), c1 = to565(lo);
+    if (c0 < c1)
+        std::swap(c0, c1);
+    std::uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = block.texels[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<std::uint32_t>(best) << (2 * i);
+        }
+    }
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// 8 bytes: two 8-bit endpoints and 3-bit indices, in the eight value mode
+inline void encodeChannel(const Block &block, int channel, unsigned char *out)
+{
+    int lo = 255, hi = 0;
+    for (const auto &texel : block.texels) {
+        lo = std::min(lo, static_cast<int>(texel[channel]));
+        hi = std::max(hi, static_cast<int>(texel[channel]));
+    }
+
+    std::uint64_t bits = static_cast<std::uint64_t>(hi) | static_cast<std::uint64_t>(lo) << 8;
+    if (hi != lo) {
+        // palette index 0 is hi, 1 is lo, 2..7 step from hi towards lo
+        int palette[8] = { hi, lo };
+        for (int p = 1; p < 7; p++)
+            palette[p + 1] = ((7 - p) * hi + p * lo) / 7;
+        for (int i = 0; i < 16; i++) {
+            int value = block.texels[i][channel], best = 0;
+            for (int p = 1; p < 8; p++)
+                if (std::abs(value - palette[p]) < std::abs(value - palette[best]))
+                    best = p;
+            bits |= static_cast<std::uint64_t>(best) << (16 + 3 * i);
+        }
+    }
+    for (int i = 0; i < 8; i++)
+        out[i] = (bits >> (8 * i)) & 0xFF;
+}
+
+inline void encodeBC1(const Block &block, unsigned char *out)
+{
+    encodeColor(block, out);
+}
+
+inline void encodeBC3(const Block &block, unsigned char *out)
+{
+    encodeChannel(block, 3, out);
+    encodeColor(block, out + 8);
+}
+
+inline void encodeBC4(const Block &block, unsigned char *out)
+{
+    encodeChannel(block, 0, out);
+}
+
+// red, then green, each like BC4
+inline void encodeBC5(const Block &block, unsigned char *out)
+{
+    encodeChannel(block, 0, out);
+    encodeChannel(block, 1, out + 8);
+}
+
+// The source texels under output texel i when size texels shrink to outSize, and the
+// share of the output each covers. Halving an odd size gives outputs a little over two
+// texels wide, so the ones in between are split and the last one is weighted in.
+inline int boxTaps(int i, int size, int outSize, int indices[4], float weights[4])
+{
+    float scale = static_cast<float>(size) / outSize;
+    float begin = i * scale, end = (i + 1) * scale;
+    int count = 0;
+    for (int s = static_cast<int>(begin); s < size && s < end && count < 4; s++) {
+        float covered = std::min(end, s + 1.0f) - std::max(begin, static_cast<float>(s));
+        if (covered > 0.0f) {
+            indices[count] = s;
+            weights[count++] = covered / scale;
+        }
+    }
+    return count;
+}
+
+// half size RGBA8 image, box filtered; odd sizes round down and every texel contributes
+inline std::vector<unsigned char> downsample(const std::vector<unsigned char> &rgba, int width, int height, int &outWidth, int &outHeight)
+{
+    outWidth = std::max(1, width / 2);
+    outHeight = std::max(1, height / 2);
+    std::vector<int> xIndices(static_cast<std::size_t>(outWidth) * 4);
+    std::vector<float> xWeights(xIndices.size());
+    std::vector<int> xCounts(outWidth);
+    for (int x = 0; x < outWidth; x++)
+        xCounts[x] = boxTaps(x, width, outWidth, &xIndices[x * 4], &xWeights[x * 4]);
+
+    std::vector<unsigned char> result(static_cast<std::size_t>(outWidth) * outHeight * 4);
+    for (int y = 0; y < outHeight; y++) {
+        int yIndices[4];
+        float yWeights[4];
+        int yCount = boxTaps(y, height, outHeight, yIndices, yWeights);
+        for (int x = 0; x < outWidth; x++) {
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int j = 0; j < yCount; j++)
+                for (int i = 0; i < xCounts[x]; i++) {
+                    const unsigned char *texel = &rgba[(static_cast<std::size_t>(yIndices[j]) * width + xIndices[x * 4 + i]) * 4];
+                    float weight = yWeights[j] * xWeights[x * 4 + i];
+                    for (int c = 0; c < 4; c++)
+                        sum[c] += weight * texel[c];
+                }
+            for (int c = 0; c < 4; c++)
+                result[(static_cast<std::size_t>(y) * outWidth + x) * 4 + c] = static_cast<unsigned char>(std::min(255.0f, sum[c] + 0.5f));
+        }
+    }
+    return result;
+}
+}
+
+}
+
+#endif //PROJECT_BASE_BLOCKCOMPRESSION_H
@@ -0,0 +1,114 @@
+#ifndef PROJECT_BASE_BLOOMPYRAMID_H
+#define PROJECT_BASE_BLOOMPYRAMID_H
+
+#include <glad/glad.h>
+#include <learnopengl/shader.h>
+#include <rg/RenderTargetPool.h>
+#include <algorithm>
+#include <vector>
+
+namespace rg {
+
+// Mip-chain bloom: the bright pass is downsampled to 1/2, 1/4, ... of its size and then
+// upsampled back level by level, each level added onto the next larger one. The glow
+// widens with every level while most of the passes run on small targets.
+class BloomPyramid {
+public:
+    // downsample and upsample are the bloomShaders/downsample.fs and upsample.fs programs,
+    // both compiled with bloomShaders/sample.vs
+    BloomPyramid(unsigned int levels, Shader &downsample, Shader &upsample)
+        : m_maxLevels(levels), m_downsample(downsample), m_upsample(upsample)
+    {
+        m_downsample.use();
+        m_downsample.setInt("image", 0);
+        m_upsample.use();
+        m_upsample.setInt("image", 0);
+
+        // sample.vs builds its triangle from gl_VertexID, but core profile still needs a VAO bound
+        glGenVertexArrays(1, &m_vao);
+    }
+
+    ~BloomPyramid()
+    {
+        glDeleteVertexArrays(1, &m_vao);
+    }
+
+    BloomPyramid(const BloomPyramid&) = delete;
+    BloomPyramid& operator=(const BloomPyramid&) = delete;
+
+    // Blurs source, a texture at the pool's internal resolution, through levels taken
+    // from the pool. Returns the half resolution level holding the sum of all levels;
+    // the caller releases it once it has been read. Leaves the default framebuffer
+    // bound and restores the viewport.
+    GLuint render(GLuint source, RenderTargetPool &targets, float filterRadius = 1.0f)
+    {
+        const TargetFormat format = TargetFormat::texture(GL_RGBA16F);
+
+        m_levels.clear();
+        int levelWidth = targets.width(), levelHeight = targets.height();
+        for (unsigned int i = 0; i < m_maxLevels && (levelWidth > 1 || levelHeight > 1); i++) {
+            Level level;
+            level.width = levelWidth = std::max(1, levelWidth / 2);
+            level.height = levelHeight = std::max(1, levelHeight / 2);
+            level.texture = targets.acquire(format, level.width, level.height);
+            level.fbo = targets.framebuffer({ level.texture });
+            m_levels.push_back(level);
+        }
+        if (m_levels.empty())
+            return 0;
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindVertexArray(m_vao);
+        glActiveTexture(GL_TEXTURE0);
+
+        m_downsample.use();
+        GLuint input = source;
+        for (Level &level : m_levels) {
+            glBindFramebuffer(GL_FRAMEBUFFER, level.fbo);
+            glViewport(0, 0, level.width, level.height);
+            glBindTexture(GL_TEXTURE_2D, input);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            input = level.texture;
+        }
+
+        m_upsample.use();
+        m_upsample.setFloat("filterRadius", filterRadius);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (std::size_t i = m_levels.size() - 1; i > 0; i--) {
+            glBindFramebuffer(GL_FRAMEBUFFER, m_levels[i - 1].fbo);
+            glViewport(0, 0, m_levels[i - 1].width, m_levels[i - 1].height);
+            glBindTexture(GL_TEXTURE_2D, m_levels[i].texture);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            targets.release(m_levels[i].texture);
+        }
+        glDisable(GL_BLEND);
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        return m_levels[0].texture;
+    }
+
+    // number of levels used by the last render()
+    unsigned int levels() const { return static_cast<unsigned int>(m_levels.size()); }
+
+private:
+    struct Level {
+        GLuint fbo = 0;
+        GLuint texture = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    unsigned int m_maxLevels;
+    Shader &m_downsample;
+    Shader &m_upsample;
+    GLuint m_vao = 0;
+    std::vector<Level> m_levels;
+};
+
+}
+
+#endif //PROJECT_BASE_BLOOMPYRAMID_H
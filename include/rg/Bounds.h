@@ -0,0 +1,72 @@
+#ifndef PROJECT_BASE_BOUNDS_H
+#define PROJECT_BASE_BOUNDS_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <limits>
+
+namespace rg {
+
+// Object-space bounding volumes: an AABB and a bounding sphere around the AABB center.
+// A default constructed Bounds is unbounded and never culled.
+struct Bounds {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = std::numeric_limits<float>::infinity();
+
+    // positions are the first three floats of every vertex, stride is given in floats
+    static Bounds fromPositions(const float *data, std::size_t count, std::size_t stride)
+    {
+        Bounds bounds;
+        if (count == 0)
+            return bounds;
+        for (std::size_t i = 0; i < count; i++) {
+            glm::vec3 position(data[i * stride], data[i * stride + 1], data[i * stride + 2]);
+            bounds.min = glm::min(bounds.min, position);
+            bounds.max = glm::max(bounds.max, position);
+        }
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        bounds.radius = 0.0f;
+        for (std::size_t i = 0; i < count; i++) {
+            glm::vec3 position(data[i * stride], data[i * stride + 1], data[i * stride + 2]);
+            bounds.radius = std::max(bounds.radius, glm::length(position - bounds.center));
+        }
+        return bounds;
+    }
+
+    bool empty() const { return min.x > max.x; }
+
+    // grows the bounds to contain other, the sphere is kept around the new AABB center
+    void merge(const Bounds &other)
+    {
+        if (other.empty())
+            return;
+        if (empty()) {
+            *this = other;
+            return;
+        }
+        glm::vec3 oldCenter = center;
+        float oldRadius = radius;
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+        center = (min + max) * 0.5f;
+        radius = std::max(glm::length(oldCenter - center) + oldRadius,
+                          glm::length(other.center - center) + other.radius);
+    }
+
+    // world-space sphere as (center, radius); non-uniform scale takes the largest axis
+    glm::vec4 worldSphere(const glm::mat4 &world) const
+    {
+        glm::vec3 worldCenter = glm::vec3(world * glm::vec4(center, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(world[0])),
+                               std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+        return glm::vec4(worldCenter, radius * scale);
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_BOUNDS_H
@@ -0,0 +1,128 @@
+#ifndef PROJECT_BASE_DYNAMICRESOLUTION_H
+#define PROJECT_BASE_DYNAMICRESOLUTION_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+// Measures the GPU time of every frame with GL_TIME_ELAPSED queries and picks the
+// render scale that keeps it under a budget. Results are read a few frames late
+// from a ring of queries so the CPU never waits on the GPU.
+class DynamicResolution {
+public:
+    explicit DynamicResolution(float targetMilliseconds, float minScale = 0.5f, float maxScale = 1.0f)
+        : m_targetMilliseconds(targetMilliseconds), m_minScale(minScale), m_maxScale(maxScale), m_scale(maxScale)
+    {
+        glGenQueries(QUERY_COUNT, m_queries);
+    }
+
+    ~DynamicResolution()
+    {
+        glDeleteQueries(QUERY_COUNT, m_queries);
+    }
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // brackets the GPU work of a frame, only one GL_TIME_ELAPSED query can be active at a time
+    void beginFrame()
+    {
+        collect();
+        if (m_pending[m_next])
+            return; // every query still in flight, this frame goes unmeasured
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next]);
+        m_measuring = true;
+    }
+
+    void endFrame()
+    {
+        if (!m_measuring)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        m_measuring = false;
+        m_pending[m_next] = true;
+        m_next = (m_next + 1) % QUERY_COUNT;
+    }
+
+    void setEnabled(bool enabled)
+    {
+        m_enabled = enabled;
+        if (!enabled)
+            m_scale = m_maxScale;
+    }
+
+    bool enabled() const { return m_enabled; }
+    void setTarget(float milliseconds) { m_targetMilliseconds = milliseconds; }
+    float target() const { return m_targetMilliseconds; }
+
+    // smoothed GPU time of the recent frames
+    float gpuMilliseconds() const { return m_gpuMilliseconds; }
+    float scale() const { return m_scale; }
+
+private:
+    static const int QUERY_COUNT = 4;
+    // scale changes reallocate the render targets, so the scale moves in coarse steps
+    static constexpr float SCALE_STEP = 0.05f;
+
+    GLuint m_queries[QUERY_COUNT];
+    bool m_pending[QUERY_COUNT] = {};
+    int m_next = 0;
+    bool m_measuring = false;
+    bool m_enabled = true;
+
+    float m_targetMilliseconds;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    float m_gpuMilliseconds = 0.0f;
+    int m_framesSinceChange = 0;
+
+    void collect()
+    {
+        // the oldest query finishes first, stop at the first one that isn't ready
+        for (int i = 0; i < QUERY_COUNT; i++) {
+            int index = (m_next + i) % QUERY_COUNT;
+            if (!m_pending[index])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(m_queries[index], GL_QUERY_RESULT, &nanoseconds);
+            m_pending[index] = false;
+            addSample(nanoseconds / 1.0e6f);
+        }
+    }
+
+    void addSample(float milliseconds)
+    {
+        m_gpuMilliseconds = m_gpuMilliseconds == 0.0f ? milliseconds : m_gpuMilliseconds * 0.9f + milliseconds * 0.1f;
+        if (!m_enabled)
+            return;
+
+        // let the average settle at the new resolution before judging it
+        if (++m_framesSinceChange < 10)
+            return;
+
+        // GPU time scales roughly with the pixel count, i.e. with the square of the scale
+        float wanted = m_scale;
+        if (m_gpuMilliseconds > m_targetMilliseconds)
+            wanted = m_scale * std::sqrt(m_targetMilliseconds / m_gpuMilliseconds);
+        else if (m_gpuMilliseconds < m_targetMilliseconds * 0.8f)
+            wanted = m_scale + SCALE_STEP; // grow slowly, shrink quickly
+
+        wanted = std::round(wanted / SCALE_STEP) * SCALE_STEP;
+        wanted = std::max(m_minScale, std::min(wanted, m_maxScale));
+        if (wanted != m_scale) {
+            m_scale = wanted;
+            m_framesSinceChange = 0;
+        }
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_DYNAMICRESOLUTION_H
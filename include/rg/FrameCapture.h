@@ -0,0 +1,108 @@
+#ifndef PROJECT_BASE_FRAMECAPTURE_H
+#define PROJECT_BASE_FRAMECAPTURE_H
+
+#include <glad/glad.h>
+#include <rg/Image.h>
+#include <algorithm>
+
+namespace rg {
+
+// Asynchronous readback of the color buffer. glReadPixels goes into a pixel pack buffer
+// and returns immediately; a fence tells when the copy is done, and only then is the
+// buffer mapped, so reading a frame doesn't stall the frames rendered after it.
+class FrameCapture {
+public:
+    FrameCapture()
+    {
+        glGenBuffers(SLOTS, m_buffers);
+    }
+
+    ~FrameCapture()
+    {
+        for (Slot &slot : m_slots)
+            if (slot.fence)
+                glDeleteSync(slot.fence);
+        glDeleteBuffers(SLOTS, m_buffers);
+    }
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Starts reading the given size from the color buffer of the bound read framebuffer.
+    // tag comes back with the image. Fails if every slot is still waiting to be collected.
+    bool read(int width, int height, int tag)
+    {
+        Slot &slot = m_slots[m_next];
+        if (slot.fence)
+            return false;
+
+        slot.width = width;
+        slot.height = height;
+        slot.tag = tag;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[m_next]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr, GL_STREAM_READ);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        m_next = (m_next + 1) % SLOTS;
+        return true;
+    }
+
+    // Hands back the oldest read once the GPU has finished it. With wait the call blocks
+    // until then instead of returning false.
+    bool collect(Image &image, int &tag, bool wait = false)
+    {
+        Slot &slot = m_slots[m_oldest];
+        if (!slot.fence)
+            return false;
+
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (wait && status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            return false;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        // glReadPixels rows go bottom to top, Image rows top to bottom
+        image = Image(slot.width, slot.height);
+        std::size_t stride = static_cast<std::size_t>(slot.width) * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[m_oldest]);
+        const unsigned char *data = static_cast<const unsigned char*>(
+                glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, stride * slot.height, GL_MAP_READ_BIT));
+        if (data) {
+            for (int y = 0; y < slot.height; y++)
+                std::copy(data + y * stride, data + (y + 1) * stride, image.row(slot.height - 1 - y));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        tag = slot.tag;
+        m_oldest = (m_oldest + 1) % SLOTS;
+        return data != nullptr;
+    }
+
+    // whether a read is still waiting to be collected
+    bool pending() const { return m_slots[m_oldest].fence != nullptr; }
+
+private:
+    static const int SLOTS = 3;
+
+    struct Slot {
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        int tag = 0;
+    };
+
+    GLuint m_buffers[SLOTS];
+    Slot m_slots[SLOTS];
+    int m_next = 0;
+    int m_oldest = 0;
+};
+
+}
+
+#endif //PROJECT_BASE_FRAMECAPTURE_H
@@ -0,0 +1,100 @@
+#ifndef PROJECT_BASE_FRAMEUNIFORMS_H
+#define PROJECT_BASE_FRAMEUNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstring>
+#include <vector>
+
+namespace rg {
+
+// Fixed binding points of the uniform blocks shared by all scene shaders.
+enum UniformBlockBinding : GLuint {
+    FRAME_DATA_BINDING = 0,
+    LIGHT_DATA_BINDING = 1,
+    MATERIAL_DATA_BINDING = 2,
+};
+
+// std140 mirror of the FrameData block declared in the shaders.
+struct FrameData {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos; // xyz used, w is std140 padding
+};
+
+// std140 mirror of the LightData block. Only the light placement lives here,
+// the per-object light colors and attenuation are part of MaterialData.
+struct LightData {
+    glm::vec4 dirLightDirection;
+    glm::vec4 pointLightPosition;
+    glm::vec4 spotLightPosition;
+    glm::vec3 spotLightDirection;
+    GLint flashLight; // a bool in GLSL, packed into the last vec3's padding
+};
+
+static_assert(sizeof(FrameData) == 144, "FrameData must match the std140 layout");
+static_assert(sizeof(LightData) == 64, "LightData must match the std140 layout");
+
+// Binds the FrameData, LightData and MaterialData blocks of a program to their fixed
+// binding points. Programs that don't declare one of the blocks are left alone.
+void bindUniformBlocks(GLuint program)
+{
+    const char *names[] = { "FrameData", "LightData", "MaterialData" };
+    const GLuint bindings[] = { FRAME_DATA_BINDING, LIGHT_DATA_BINDING, MATERIAL_DATA_BINDING };
+    for (int i = 0; i < 3; i++) {
+        GLuint index = glGetUniformBlockIndex(program, names[i]);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, bindings[i]);
+    }
+}
+
+// Both blocks live in one buffer so that a frame costs a single glBufferSubData.
+class FrameUniforms {
+public:
+    FrameUniforms()
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_lightOffset = (sizeof(FrameData) + alignment - 1) / alignment * alignment;
+        m_staging.resize(m_lightOffset + sizeof(LightData));
+
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, m_staging.size(), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        bind();
+    }
+
+    ~FrameUniforms()
+    {
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    void update(const FrameData &frame, const LightData &light)
+    {
+        std::memcpy(m_staging.data(), &frame, sizeof(FrameData));
+        std::memcpy(m_staging.data() + m_lightOffset, &light, sizeof(LightData));
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, m_staging.size(), m_staging.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        bind();
+    }
+
+    void bind() const
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, m_buffer, 0, sizeof(FrameData));
+        glBindBufferRange(GL_UNIFORM_BUFFER, LIGHT_DATA_BINDING, m_buffer, m_lightOffset, sizeof(LightData));
+    }
+
+private:
+    GLuint m_buffer = 0;
+    GLsizeiptr m_lightOffset = 0;
+    std::vector<unsigned char> m_staging;
+};
+
+}
+
+#endif //PROJECT_BASE_FRAMEUNIFORMS_H
@@ -0,0 +1,102 @@
+#ifndef PROJECT_BASE_FRUSTUM_H
+#define PROJECT_BASE_FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RG_FRUSTUM_SSE 1
+#endif
+
+namespace rg {
+
+// Per-frame culling counters, counted per object or per Model mesh tested.
+struct CullStats {
+    unsigned int drawn = 0;
+    unsigned int culled = 0;
+};
+
+// The six clip planes of projection * view, pointing inwards.
+class Frustum {
+public:
+    static CullStats& frameStats()
+    {
+        static CullStats stats;
+        return stats;
+    }
+
+    static CullStats endFrame()
+    {
+        CullStats last = frameStats();
+        frameStats() = CullStats();
+        return last;
+    }
+
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4 &viewProjection)
+    {
+        // Gribb-Hartmann: the planes are sums and differences of the matrix rows
+        const glm::mat4 &m = viewProjection;
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        m_planes[0] = row3 + row0; // left
+        m_planes[1] = row3 - row0; // right
+        m_planes[2] = row3 + row1; // bottom
+        m_planes[3] = row3 - row1; // top
+        m_planes[4] = row3 + row2; // near
+        m_planes[5] = row3 - row2; // far
+        for (glm::vec4 &plane : m_planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    // sphere is (center, radius)
+    bool intersects(const glm::vec4 &sphere) const
+    {
+        for (const glm::vec4 &plane : m_planes)
+            if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+                return false;
+        return true;
+    }
+
+    // Tests count spheres stored as separate x, y, z and radius arrays, four at a time
+    // when SSE is available. visible[i] is set to 1 or 0.
+    void intersects(const float *x, const float *y, const float *z, const float *r,
+                    std::size_t count, unsigned char *visible) const
+    {
+        std::size_t i = 0;
+#ifdef RG_FRUSTUM_SSE
+        for (; i + 4 <= count; i += 4) {
+            __m128 cx = _mm_loadu_ps(x + i);
+            __m128 cy = _mm_loadu_ps(y + i);
+            __m128 cz = _mm_loadu_ps(z + i);
+            __m128 zero = _mm_setzero_ps();
+            __m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(r + i));
+            __m128 inside = _mm_cmpeq_ps(zero, zero); // all bits set
+            for (const glm::vec4 &plane : m_planes) {
+                __m128 distance = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                        _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+            }
+            int mask = _mm_movemask_ps(inside);
+            visible[i] = mask & 1;
+            visible[i + 1] = (mask >> 1) & 1;
+            visible[i + 2] = (mask >> 2) & 1;
+            visible[i + 3] = (mask >> 3) & 1;
+        }
+#endif
+        for (; i < count; i++)
+            visible[i] = intersects(glm::vec4(x[i], y[i], z[i], r[i])) ? 1 : 0;
+    }
+
+private:
+    glm::vec4 m_planes[6];
+};
+
+}
+
+#endif //PROJECT_BASE_FRUSTUM_H
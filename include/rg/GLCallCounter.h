@@ -0,0 +1,175 @@
+#ifndef PROJECT_BASE_GLCALLCOUNTER_H
+#define PROJECT_BASE_GLCALLCOUNTER_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+// Per-frame counts of draw calls and of calls that change pipeline state (program,
+// vertex array, texture, buffer and framebuffer bindings, capabilities, viewport).
+struct GLCallStats {
+    unsigned int drawCalls = 0;
+    unsigned int stateChanges = 0;
+};
+
+// Counts GL calls by swapping the glad function pointers for counting wrappers, so
+// every caller is covered, including imgui and the learnopengl headers.
+class GLCallCounter {
+public:
+    static GLCallStats& frameStats()
+    {
+        static GLCallStats stats;
+        return stats;
+    }
+
+    static GLCallStats endFrame()
+    {
+        GLCallStats last = frameStats();
+        frameStats() = GLCallStats();
+        return last;
+    }
+
+    // call once, after gladLoadGLLoader
+    static void install()
+    {
+        static bool installed = false;
+        if (installed)
+            return;
+        installed = true;
+
+        drawArrays() = glad_glDrawArrays;
+        glad_glDrawArrays = countDrawArrays;
+        drawElements() = glad_glDrawElements;
+        glad_glDrawElements = countDrawElements;
+        drawArraysInstanced() = glad_glDrawArraysInstanced;
+        glad_glDrawArraysInstanced = countDrawArraysInstanced;
+        drawElementsInstanced() = glad_glDrawElementsInstanced;
+        glad_glDrawElementsInstanced = countDrawElementsInstanced;
+
+        useProgram() = glad_glUseProgram;
+        glad_glUseProgram = countUseProgram;
+        bindVertexArray() = glad_glBindVertexArray;
+        glad_glBindVertexArray = countBindVertexArray;
+        activeTexture() = glad_glActiveTexture;
+        glad_glActiveTexture = countActiveTexture;
+        bindTexture() = glad_glBindTexture;
+        glad_glBindTexture = countBindTexture;
+        bindBuffer() = glad_glBindBuffer;
+        glad_glBindBuffer = countBindBuffer;
+        bindBufferRange() = glad_glBindBufferRange;
+        glad_glBindBufferRange = countBindBufferRange;
+        bindFramebuffer() = glad_glBindFramebuffer;
+        glad_glBindFramebuffer = countBindFramebuffer;
+        enable() = glad_glEnable;
+        glad_glEnable = countEnable;
+        disable() = glad_glDisable;
+        glad_glDisable = countDisable;
+        viewport() = glad_glViewport;
+        glad_glViewport = countViewport;
+    }
+
+private:
+    // the original entry points
+    static PFNGLDRAWARRAYSPROC& drawArrays() { static PFNGLDRAWARRAYSPROC f; return f; }
+    static PFNGLDRAWELEMENTSPROC& drawElements() { static PFNGLDRAWELEMENTSPROC f; return f; }
+    static PFNGLDRAWARRAYSINSTANCEDPROC& drawArraysInstanced() { static PFNGLDRAWARRAYSINSTANCEDPROC f; return f; }
+    static PFNGLDRAWELEMENTSINSTANCEDPROC& drawElementsInstanced() { static PFNGLDRAWELEMENTSINSTANCEDPROC f; return f; }
+    static PFNGLUSEPROGRAMPROC& useProgram() { static PFNGLUSEPROGRAMPROC f; return f; }
+    static PFNGLBINDVERTEXARRAYPROC& bindVertexArray() { static PFNGLBINDVERTEXARRAYPROC f; return f; }
+    static PFNGLACTIVETEXTUREPROC& activeTexture() { static PFNGLACTIVETEXTUREPROC f; return f; }
+    static PFNGLBINDTEXTUREPROC& bindTexture() { static PFNGLBINDTEXTUREPROC f; return f; }
+    static PFNGLBINDBUFFERPROC& bindBuffer() { static PFNGLBINDBUFFERPROC f; return f; }
+    static PFNGLBINDBUFFERRANGEPROC& bindBufferRange() { static PFNGLBINDBUFFERRANGEPROC f; return f; }
+    static PFNGLBINDFRAMEBUFFERPROC& bindFramebuffer() { static PFNGLBINDFRAMEBUFFERPROC f; return f; }
+    static PFNGLENABLEPROC& enable() { static PFNGLENABLEPROC f; return f; }
+    static PFNGLDISABLEPROC& disable() { static PFNGLDISABLEPROC f; return f; }
+    static PFNGLVIEWPORTPROC& viewport() { static PFNGLVIEWPORTPROC f; return f; }
+
+    static void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        frameStats().drawCalls++;
+        drawArrays()(mode, first, count);
+    }
+
+    static void APIENTRY countDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+    {
+        frameStats().drawCalls++;
+        drawElements()(mode, count, type, indices);
+    }
+
+    static void APIENTRY countDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+    {
+        frameStats().drawCalls++;
+        drawArraysInstanced()(mode, first, count, instances);
+    }
+
+    static void APIENTRY countDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instances)
+    {
+        frameStats().drawCalls++;
+        drawElementsInstanced()(mode, count, type, indices, instances);
+    }
+
+    static void APIENTRY countUseProgram(GLuint program)
+    {
+        frameStats().stateChanges++;
+        useProgram()(program);
+    }
+
+    static void APIENTRY countBindVertexArray(GLuint array)
+    {
+        frameStats().stateChanges++;
+        bindVertexArray()(array);
+    }
+
+    static void APIENTRY countActiveTexture(GLenum texture)
+    {
+        frameStats().stateChanges++;
+        activeTexture()(texture);
+    }
+
+    static void APIENTRY countBindTexture(GLenum target, GLuint texture)
+    {
+        frameStats().stateChanges++;
+        bindTexture()(target, texture);
+    }
+
+    static void APIENTRY countBindBuffer(GLenum target, GLuint buffer)
+    {
+        frameStats().stateChanges++;
+        bindBuffer()(target, buffer);
+    }
+
+    static void APIENTRY countBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        frameStats().stateChanges++;
+        bindBufferRange()(target, index, buffer, offset, size);
+    }
+
+    static void APIENTRY countBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        frameStats().stateChanges++;
+        bindFramebuffer()(target, framebuffer);
+    }
+
+    static void APIENTRY countEnable(GLenum cap)
+    {
+        frameStats().stateChanges++;
+        enable()(cap);
+    }
+
+    static void APIENTRY countDisable(GLenum cap)
+    {
+        frameStats().stateChanges++;
+        disable()(cap);
+    }
+
+    static void APIENTRY countViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        frameStats().stateChanges++;
+        viewport()(x, y, width, height);
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_GLCALLCOUNTER_H
@@ -0,0 +1,65 @@
+#ifndef PROJECT_BASE_GAUSSIANKERNEL_H
+#define PROJECT_BASE_GAUSSIANKERNEL_H
+
+#include <glad/glad.h>
+#include <learnopengl/shader.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace rg {
+
+// One side of a separable Gaussian blur, taking advantage of bilinear filtering:
+// two neighbouring texels are read with a single fetch placed between them, so a
+// radius r blur takes 1 + ceil(r / 2) fetches per side instead of 1 + r.
+// offsets[0] is the center tap, the others are mirrored by the shader.
+struct GaussianKernel {
+    // must match MAX_TAPS in bloomShaders/blur.fs
+    static const int MAX_TAPS = 16;
+    static const int MAX_RADIUS = 2 * (MAX_TAPS - 1);
+
+    std::vector<float> offsets;
+    std::vector<float> weights;
+
+    GaussianKernel(int radius, float sigma)
+    {
+        radius = std::max(1, std::min(radius, int(MAX_RADIUS)));
+
+        std::vector<double> discrete(radius + 1);
+        double sum = 0.0;
+        for (int i = 0; i <= radius; i++) {
+            discrete[i] = std::exp(-0.5 * i * i / (sigma * sigma));
+            sum += i == 0 ? discrete[i] : 2.0 * discrete[i];
+        }
+        for (double &weight : discrete)
+            weight /= sum;
+
+        offsets.push_back(0.0f);
+        weights.push_back(static_cast<float>(discrete[0]));
+        for (int i = 1; i <= radius; i += 2) {
+            if (i + 1 > radius) {
+                offsets.push_back(static_cast<float>(i));
+                weights.push_back(static_cast<float>(discrete[i]));
+                break;
+            }
+            // the fetch lands where the bilinear weights reproduce both texel weights
+            double weight = discrete[i] + discrete[i + 1];
+            offsets.push_back(static_cast<float>((i * discrete[i] + (i + 1) * discrete[i + 1]) / weight));
+            weights.push_back(static_cast<float>(weight));
+        }
+    }
+
+    int taps() const { return static_cast<int>(offsets.size()); }
+
+    // sets tapCount, offsets and weights of the blur program, which must be in use
+    void upload(const Shader &shader) const
+    {
+        shader.setInt("tapCount", taps());
+        glUniform1fv(shader.uniformLocation("offsets"), taps(), offsets.data());
+        glUniform1fv(shader.uniformLocation("weights"), taps(), weights.data());
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_GAUSSIANKERNEL_H
@@ -0,0 +1,187 @@
+#ifndef PROJECT_BASE_IMAGE_H
+#define PROJECT_BASE_IMAGE_H
+
+#include <stb_image.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// 8-bit RGBA pixels, rows stored top to bottom.
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+
+    Image() = default;
+    Image(int width, int height)
+        : width(width), height(height), pixels(static_cast<std::size_t>(width) * height * 4, 0)
+    {}
+
+    unsigned char* row(int y) { return pixels.data() + static_cast<std::size_t>(y) * width * 4; }
+    const unsigned char* row(int y) const { return pixels.data() + static_cast<std::size_t>(y) * width * 4; }
+};
+
+// Result of comparing two images channel by channel.
+struct ImageDiff {
+    bool sizeMatches = true;
+    unsigned int differingPixels = 0; // pixels with a channel off by more than the tolerance
+    int maxDelta = 0;                 // largest difference of any channel
+};
+
+namespace png {
+
+inline std::uint32_t crc32(const unsigned char *data, std::size_t size, std::uint32_t crc = 0)
+{
+    static std::uint32_t table[256];
+    static bool initialized = false;
+    if (!initialized) {
+        for (std::uint32_t n = 0; n < 256; n++) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        initialized = true;
+    }
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline std::uint32_t adler32(const unsigned char *data, std::size_t size)
+{
+    std::uint32_t a = 1, b = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+inline void putBigEndian(std::vector<unsigned char> &out, std::uint32_t value)
+{
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+inline void writeChunk(std::ostream &file, const char *type, const std::vector<unsigned char> &data)
+{
+    std::vector<unsigned char> chunk;
+    putBigEndian(chunk, static_cast<std::uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+}
+
+// Writes an uncompressed PNG: the zlib stream holds only stored deflate blocks, which
+// keeps the writer small and exact at the cost of file size.
+inline bool writePng(const std::string &path, const Image &image)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<unsigned char> header;
+    png::putBigEndian(header, image.width);
+    png::putBigEndian(header, image.height);
+    header.push_back(8); // bit depth
+    header.push_back(6); // RGBA
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering
+    header.push_back(0); // no interlacing
+    png::writeChunk(file, "IHDR", header);
+
+    // every scanline is prefixed with filter type 0 (none)
+    std::size_t stride = static_cast<std::size_t>(image.width) * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * image.height);
+    for (int y = 0; y < image.height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), image.row(y), image.row(y) + stride);
+    }
+
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    const std::size_t MAX_BLOCK = 65535;
+    std::size_t offset = 0;
+    do {
+        std::size_t size = std::min(MAX_BLOCK, raw.size() - offset);
+        bool last = offset + size == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(size & 0xFF);
+        zlib.push_back(size >> 8);
+        zlib.push_back(~size & 0xFF);
+        zlib.push_back((~size >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    } while (offset < raw.size());
+    png::putBigEndian(zlib, png::adler32(raw.data(), raw.size()));
+    png::writeChunk(file, "IDAT", zlib);
+
+    png::writeChunk(file, "IEND", {});
+    return static_cast<bool>(file);
+}
+
+// loads any image stb_image understands, converted to RGBA
+inline bool loadImage(const std::string &path, Image &image)
+{
+    int width, height, components;
+    unsigned char *data = stbi_load(path.c_str(), &width, &height, &components, 4);
+    if (!data)
+        return false;
+    image = Image(width, height);
+    std::copy(data, data + image.pixels.size(), image.pixels.begin());
+    stbi_image_free(data);
+    return true;
+}
+
+// Compares a and b channel by channel. If diff is given it receives an image with the
+// differing pixels in red over a darkened copy of a.
+inline ImageDiff compareImages(const Image &a, const Image &b, int tolerance, Image *diff = nullptr)
+{
+    ImageDiff result;
+    if (a.width != b.width || a.height != b.height) {
+        result.sizeMatches = false;
+        return result;
+    }
+    if (diff)
+        *diff = Image(a.width, a.height);
+
+    for (std::size_t i = 0; i < a.pixels.size(); i += 4) {
+        int delta = 0;
+        for (int c = 0; c < 4; c++)
+            delta = std::max(delta, std::abs(a.pixels[i + c] - b.pixels[i + c]));
+        result.maxDelta = std::max(result.maxDelta, delta);
+        bool differs = delta > tolerance;
+        if (differs)
+            result.differingPixels++;
+        if (diff) {
+            unsigned char *out = &diff->pixels[i];
+            for (int c = 0; c < 3; c++)
+                out[c] = a.pixels[i + c] / 4;
+            if (differs) {
+                out[0] = 255;
+                out[1] = out[2] = 0;
+            }
+            out[3] = 255;
+        }
+    }
+    return result;
+}
+
+}
+
+#endif //PROJECT_BASE_IMAGE_H
@@ -0,0 +1,73 @@
+#ifndef PROJECT_BASE_INSTANCEBUFFER_H
+#define PROJECT_BASE_INSTANCEBUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace rg {
+
+// Per-instance model matrices for glDrawArraysInstanced/glDrawElementsInstanced.
+// Shaders compiled with INSTANCED read the matrix from aInstanceModel at location 5.
+class InstanceBuffer {
+public:
+    // a mat4 attribute takes four consecutive vec4 locations, 5-8, right after the Mesh attributes
+    static const GLuint MODEL_ATTRIBUTE = 5;
+
+    InstanceBuffer()
+    {
+        glGenBuffers(1, &m_buffer);
+    }
+
+    ~InstanceBuffer()
+    {
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Adds the instance matrix attributes to a VAO. One buffer can feed any number of VAOs,
+    // e.g. all meshes of a Model. first makes instance 0 read the matrix at that index,
+    // standing in for the base instance GL 3.3 lacks.
+    void attach(GLuint vao, GLsizei first = 0) const
+    {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        for (GLuint i = 0; i < 4; i++) {
+            glEnableVertexAttribArray(MODEL_ATTRIBUTE + i);
+            glVertexAttribPointer(MODEL_ATTRIBUTE + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(first * sizeof(glm::mat4) + i * sizeof(glm::vec4)));
+            glVertexAttribDivisor(MODEL_ATTRIBUTE + i, 1);
+        }
+        glBindVertexArray(0);
+    }
+
+    void update(const std::vector<glm::mat4> &models)
+    {
+        update(models.data(), models.size());
+    }
+
+    void update(const glm::mat4 *models, std::size_t count)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        if (count > m_capacity) {
+            glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), models, GL_DYNAMIC_DRAW);
+            m_capacity = count;
+        } else if (count > 0) {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), models);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_count = static_cast<GLsizei>(count);
+    }
+
+    GLsizei count() const { return m_count; }
+
+private:
+    GLuint m_buffer = 0;
+    std::size_t m_capacity = 0;
+    GLsizei m_count = 0;
+};
+
+}
+
+#endif //PROJECT_BASE_INSTANCEBUFFER_H
@@ -0,0 +1,72 @@
+#ifndef PROJECT_BASE_LOD_H
+#define PROJECT_BASE_LOD_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace rg {
+
+// One level of detail of a Mesh: a range of its index buffer and how far, in object space,
+// the simplified surface may be from the full one. Level 0 is the full mesh.
+struct MeshLod {
+    unsigned int first = 0; // in indices
+    unsigned int count = 0;
+    float error = 0.0f;
+};
+
+// Per-frame triangle counters, as drawn and as they would be at full detail.
+struct LodStats {
+    unsigned long triangles = 0;
+    unsigned long fullTriangles = 0;
+};
+
+// Picks levels by projected size: the coarsest level whose error covers fewer than
+// pixelThreshold pixels at the object's distance. Built once per frame from the camera.
+class LodSelector {
+public:
+    static LodStats& frameStats()
+    {
+        static LodStats stats;
+        return stats;
+    }
+
+    static LodStats endFrame()
+    {
+        LodStats last = frameStats();
+        frameStats() = LodStats();
+        return last;
+    }
+
+    float pixelThreshold = 1.0f;
+
+    // fovY in radians, viewportHeight in pixels
+    LodSelector(const glm::vec3 &cameraPosition, float fovY, float viewportHeight)
+        : m_cameraPosition(cameraPosition),
+          m_pixelsPerUnit(viewportHeight / (2.0f * std::tan(fovY * 0.5f)))
+    {
+    }
+
+    // errors[l] is the object-space error of level l; sphere is the world-space bounding
+    // sphere as (center, radius) and objectRadius its radius before the world transform
+    unsigned int select(const std::vector<float> &errors, const glm::vec4 &sphere, float objectRadius) const
+    {
+        float distance = glm::length(glm::vec3(sphere) - m_cameraPosition) - sphere.w;
+        if (distance <= 0.0f || !std::isfinite(objectRadius) || objectRadius <= 0.0f)
+            return 0;
+        float pixelsPerObjectUnit = m_pixelsPerUnit / distance * (sphere.w / objectRadius);
+        unsigned int level = 0;
+        while (level + 1 < errors.size() && errors[level + 1] * pixelsPerObjectUnit <= pixelThreshold)
+            level++;
+        return level;
+    }
+
+private:
+    glm::vec3 m_cameraPosition;
+    float m_pixelsPerUnit;
+};
+
+}
+
+#endif //PROJECT_BASE_LOD_H
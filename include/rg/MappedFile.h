@@ -0,0 +1,62 @@
+#ifndef PROJECT_BASE_MAPPEDFILE_H
+#define PROJECT_BASE_MAPPEDFILE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include <string>
+
+namespace rg {
+
+// Read-only memory mapping of a whole file; pages are read in on first access instead of
+// being copied into a buffer up front.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = static_cast<const unsigned char*>(data);
+                m_size = static_cast<std::size_t>(info.st_size);
+            }
+        }
+        close(fd); // the mapping keeps the file open
+    }
+
+    ~MappedFile()
+    {
+        if (m_data)
+            munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return m_data != nullptr; }
+    const unsigned char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+    // modification time in seconds, 0 if the file doesn't exist
+    static long modificationTime(const std::string &path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return 0;
+        return static_cast<long>(info.st_mtime);
+    }
+
+private:
+    const unsigned char *m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+}
+
+#endif //PROJECT_BASE_MAPPEDFILE_H
@@ -0,0 +1,147 @@
+#ifndef PROJECT_BASE_MATERIAL_H
+#define PROJECT_BASE_MATERIAL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/shader.h>
+#include <rg/FrameUniforms.h>
+#include <cstring>
+#include <vector>
+
+namespace rg {
+
+// std140 mirrors of the DirLight, PointLight and SpotLight structs in the MaterialData
+// block. They hold how strongly an object responds to each light, not where the light is.
+struct DirLightData {
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+
+    DirLightData() = default;
+    DirLightData(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular)
+        : ambient(ambient, 0.0f), diffuse(diffuse, 0.0f), specular(specular, 0.0f) {}
+};
+
+struct PointLightData {
+    float constant;
+    float linear;
+    float quadratic;
+    float padding;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+
+    PointLightData() = default;
+    PointLightData(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular,
+                   float constant, float linear, float quadratic)
+        : constant(constant), linear(linear), quadratic(quadratic), padding(0.0f)
+        , ambient(ambient, 0.0f), diffuse(diffuse, 0.0f), specular(specular, 0.0f) {}
+};
+
+struct SpotLightData {
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding[3];
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+
+    SpotLightData() = default;
+    SpotLightData(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular,
+                  float constant, float linear, float quadratic, float cutOff, float outerCutOff)
+        : cutOff(cutOff), outerCutOff(outerCutOff), constant(constant), linear(linear), quadratic(quadratic)
+        , padding{0.0f, 0.0f, 0.0f}, ambient(ambient, 0.0f), diffuse(diffuse, 0.0f), specular(specular, 0.0f) {}
+};
+
+struct MaterialData {
+    DirLightData dirLight;
+    PointLightData pointLight;
+    SpotLightData spotLight;
+    float shininess;
+    float padding[3];
+};
+
+static_assert(sizeof(DirLightData) == 48, "DirLightData must match the std140 layout");
+static_assert(sizeof(PointLightData) == 64, "PointLightData must match the std140 layout");
+static_assert(sizeof(SpotLightData) == 80, "SpotLightData must match the std140 layout");
+static_assert(sizeof(MaterialData) == 208, "MaterialData must match the std140 layout");
+
+// What changes from one draw to the next for objects sharing a program:
+// the MaterialData block to bind and the texture units of the material samplers.
+struct Material {
+    unsigned int block = 0;
+    GLint diffuseUnit = 0;
+    GLint specularUnit = 0;
+};
+
+// Locations of material.diffuse and material.specular in one program.
+struct MaterialSamplers {
+    GLint diffuse = -1;
+    GLint specular = -1;
+
+    MaterialSamplers() = default;
+    explicit MaterialSamplers(const Shader &shader)
+        : diffuse(shader.uniformLocation("material.diffuse")), specular(shader.uniformLocation("material.specular")) {}
+};
+
+// All materials packed into one uniform buffer; selecting one is a single glBindBufferRange.
+class MaterialBuffer {
+public:
+    MaterialBuffer()
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_stride = (sizeof(MaterialData) + alignment - 1) / alignment * alignment;
+        glGenBuffers(1, &m_buffer);
+    }
+
+    ~MaterialBuffer()
+    {
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    MaterialBuffer(const MaterialBuffer&) = delete;
+    MaterialBuffer& operator=(const MaterialBuffer&) = delete;
+
+    // Returns the block index to store in Material::block. Call upload() after the last add.
+    unsigned int add(const MaterialData &data)
+    {
+        unsigned int block = m_count++;
+        m_staging.resize(m_count * m_stride);
+        std::memcpy(m_staging.data() + block * m_stride, &data, sizeof(MaterialData));
+        return block;
+    }
+
+    void upload()
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, m_staging.size(), m_staging.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void bind(unsigned int block) const
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_DATA_BINDING, m_buffer, block * m_stride, sizeof(MaterialData));
+    }
+
+    // Binds the material's block and points the samplers of the current program at its texture units.
+    void apply(const Material &material, const MaterialSamplers &samplers) const
+    {
+        bind(material.block);
+        glUniform1i(samplers.diffuse, material.diffuseUnit);
+        glUniform1i(samplers.specular, material.specularUnit);
+    }
+
+private:
+    GLuint m_buffer = 0;
+    GLsizeiptr m_stride = 0;
+    unsigned int m_count = 0;
+    std::vector<unsigned char> m_staging;
+};
+
+}
+
+#endif //PROJECT_BASE_MATERIAL_H
@@ -0,0 +1,253 @@
+#ifndef PROJECT_BASE_MESHCACHE_H
+#define PROJECT_BASE_MESHCACHE_H
+
+#include <learnopengl/mesh.h>
+#include <rg/MappedFile.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Cooked meshes of a model file, stored next to it as <model>.meshcache: the processed
+// vertex and index arrays, the level of detail table and the texture bindings of every
+// mesh, so later runs can map the file and upload the arrays without importing the model
+// again.
+//
+// The cache is keyed by a hash of the model file, the material libraries it references,
+// the import flags and the Vertex layout; a cache whose key doesn't match is ignored and
+// overwritten after the next import.
+class MeshCache {
+public:
+    struct TextureRef {
+        std::string type;
+        std::string path; // relative to the model's directory
+    };
+
+    // points into the mapped file, valid while the MeshCache is alive
+    struct CookedMesh {
+        const Vertex *vertices = nullptr;
+        std::size_t vertexCount = 0;
+        const unsigned int *indices = nullptr;
+        std::size_t indexCount = 0;
+        std::vector<TextureRef> textures;
+        std::vector<MeshLod> lods;
+    };
+
+    static std::string cachePath(const std::string &source)
+    {
+        return source + ".meshcache";
+    }
+
+    static std::uint64_t key(const std::string &source, unsigned int importFlags)
+    {
+        std::uint64_t hash = FNV_OFFSET;
+        std::uint32_t version = VERSION;
+        hash = fnv1a(&version, sizeof(version), hash);
+        hash = fnv1a(&importFlags, sizeof(importFlags), hash);
+        std::uint32_t vertexSize = sizeof(Vertex);
+        hash = fnv1a(&vertexSize, sizeof(vertexSize), hash);
+
+        MappedFile file(source);
+        if (!file.valid())
+            return hash;
+        hash = fnv1a(file.data(), file.size(), hash);
+
+        // OBJ materials live in separate files named by mtllib lines
+        std::string directory = source.substr(0, source.find_last_of('/'));
+        const char *text = reinterpret_cast<const char*>(file.data());
+        for (std::size_t line = 0; line < file.size();) {
+            std::size_t end = line;
+            while (end < file.size() && text[end] != '\n')
+                end++;
+            if (end - line > 7 && std::strncmp(text + line, "mtllib ", 7) == 0) {
+                std::string name(text + line + 7, end - line - 7);
+                while (!name.empty() && (name.back() == '\r' || name.back() == ' '))
+                    name.pop_back();
+                MappedFile library(directory + "/" + name);
+                if (library.valid())
+                    hash = fnv1a(library.data(), library.size(), hash);
+            }
+            line = end + 1;
+        }
+        return hash;
+    }
+
+    // maps the cache of source, false if there is none or it doesn't match key
+    bool open(const std::string &source, std::uint64_t key)
+    {
+        m_meshes.clear();
+        m_file.reset(new MappedFile(cachePath(source)));
+        if (!m_file->valid())
+            return false;
+
+        Reader reader{ m_file->data(), m_file->size(), 0 };
+        char magic[4];
+        std::uint32_t version = 0, meshCount = 0;
+        std::uint64_t storedKey = 0;
+        if (!reader.read(magic, 4) || std::memcmp(magic, "RGMC", 4) != 0 || !reader.read(&version, sizeof(version))
+            || version != VERSION || !reader.read(&storedKey, sizeof(storedKey)) || storedKey != key
+            || !reader.read(&meshCount, sizeof(meshCount)))
+            return false;
+
+        for (std::uint32_t i = 0; i < meshCount; i++) {
+            CookedMesh mesh;
+            std::uint64_t vertexCount = 0, indexCount = 0;
+            std::uint32_t textureCount = 0, lodCount = 0;
+            if (!reader.read(&vertexCount, sizeof(vertexCount)) || !reader.read(&indexCount, sizeof(indexCount))
+                || !reader.read(&textureCount, sizeof(textureCount)) || !reader.read(&lodCount, sizeof(lodCount)))
+                return false;
+            // counts come from the file, check them against what is left before sizing anything
+            if (lodCount > reader.remaining() / sizeof(MeshLod))
+                return false;
+            mesh.lods.resize(lodCount);
+            if (!reader.read(mesh.lods.data(), lodCount * sizeof(MeshLod)))
+                return false;
+            for (const MeshLod &lod : mesh.lods)
+                if (lod.first + static_cast<std::uint64_t>(lod.count) > indexCount)
+                    return false;
+            for (std::uint32_t t = 0; t < textureCount; t++) {
+                TextureRef texture;
+                if (!reader.readString(texture.type) || !reader.readString(texture.path))
+                    return false;
+                mesh.textures.push_back(texture);
+            }
+            reader.align(alignof(Vertex));
+            if (vertexCount > reader.remaining() / sizeof(Vertex) || indexCount > reader.remaining() / sizeof(unsigned int))
+                return false;
+            mesh.vertices = reinterpret_cast<const Vertex*>(reader.skip(vertexCount * sizeof(Vertex)));
+            mesh.indices = reinterpret_cast<const unsigned int*>(reader.skip(indexCount * sizeof(unsigned int)));
+            if (!mesh.vertices || !mesh.indices)
+                return false;
+            mesh.vertexCount = vertexCount;
+            mesh.indexCount = indexCount;
+            m_meshes.push_back(mesh);
+        }
+        return true;
+    }
+
+    const std::vector<CookedMesh>& meshes() const { return m_meshes; }
+
+    // meshes must still hold their CPU copies, i.e. come from an import
+    static bool write(const std::string &source, std::uint64_t key, const std::vector<Mesh> &meshes)
+    {
+        std::ofstream file(cachePath(source), std::ios::binary);
+        if (!file)
+            return false;
+
+        Writer writer{ file, 0 };
+        std::uint32_t version = VERSION, meshCount = static_cast<std::uint32_t>(meshes.size());
+        writer.write("RGMC", 4);
+        writer.write(&version, sizeof(version));
+        writer.write(&key, sizeof(key));
+        writer.write(&meshCount, sizeof(meshCount));
+        for (const Mesh &mesh : meshes) {
+            std::uint64_t vertexCount = mesh.vertices.size(), indexCount = mesh.indices.size();
+            std::uint32_t textureCount = static_cast<std::uint32_t>(mesh.textures.size());
+            std::uint32_t lodCount = static_cast<std::uint32_t>(mesh.lods.size());
+            writer.write(&vertexCount, sizeof(vertexCount));
+            writer.write(&indexCount, sizeof(indexCount));
+            writer.write(&textureCount, sizeof(textureCount));
+            writer.write(&lodCount, sizeof(lodCount));
+            writer.write(mesh.lods.data(), lodCount * sizeof(MeshLod));
+            for (const Texture &texture : mesh.textures) {
+                writer.writeString(texture.type);
+                writer.writeString(texture.path);
+            }
+            writer.align(alignof(Vertex));
+            writer.write(mesh.vertices.data(), vertexCount * sizeof(Vertex));
+            writer.write(mesh.indices.data(), indexCount * sizeof(unsigned int));
+        }
+        return static_cast<bool>(file);
+    }
+
+private:
+    static const std::uint32_t VERSION = 3; // 2: optimized index and vertex order, 3: levels of detail
+    static const std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+
+    std::unique_ptr<MappedFile> m_file;
+    std::vector<CookedMesh> m_meshes;
+
+    static std::uint64_t fnv1a(const void *data, std::size_t size, std::uint64_t hash)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    struct Reader {
+        const unsigned char *data;
+        std::size_t size;
+        std::size_t offset;
+
+        std::size_t remaining() const { return size - offset; }
+
+        const unsigned char* skip(std::size_t bytes)
+        {
+            if (bytes > size - offset)
+                return nullptr;
+            const unsigned char *at = data + offset;
+            offset += bytes;
+            return at;
+        }
+
+        bool read(void *out, std::size_t bytes)
+        {
+            const unsigned char *at = skip(bytes);
+            if (at)
+                std::memcpy(out, at, bytes);
+            return at != nullptr;
+        }
+
+        bool readString(std::string &out)
+        {
+            std::uint32_t length = 0;
+            if (!read(&length, sizeof(length)))
+                return false;
+            const unsigned char *at = skip(length);
+            if (at)
+                out.assign(reinterpret_cast<const char*>(at), length);
+            return at != nullptr;
+        }
+
+        void align(std::size_t alignment)
+        {
+            offset = std::min(size, (offset + alignment - 1) / alignment * alignment);
+        }
+    };
+
+    struct Writer {
+        std::ofstream &file;
+        std::size_t offset;
+
+        void write(const void *data, std::size_t bytes)
+        {
+            file.write(static_cast<const char*>(data), bytes);
+            offset += bytes;
+        }
+
+        void writeString(const std::string &value)
+        {
+            std::uint32_t length = static_cast<std::uint32_t>(value.size());
+            write(&length, sizeof(length));
+            write(value.data(), length);
+        }
+
+        void align(std::size_t alignment)
+        {
+            const char zeros[16] = {};
+            write(zeros, (alignment - offset % alignment) % alignment);
+        }
+    };
+};
+
+}
+
+#endif //PROJECT_BASE_MESHCACHE_H
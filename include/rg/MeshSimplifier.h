@@ -0,0 +1,340 @@
+#ifndef PROJECT_BASE_MESHSIMPLIFIER_H
+#define PROJECT_BASE_MESHSIMPLIFIER_H
+
+#include <glm/glm.hpp>
+#include <rg/Lod.h>
+#include <rg/MeshOptimizer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace rg {
+
+namespace meshopt {
+
+// Error quadric of Garland and Heckbert, the sum of squared distances to a set of planes,
+// weighted by triangle area. Kept as the upper half of the symmetric 4x4 matrix.
+struct Quadric {
+    double a[10] = {};
+    double weight = 0.0;
+
+    static Quadric plane(const glm::dvec3 &normal, double d, double weight)
+    {
+        Quadric q;
+        double p[4] = { normal.x, normal.y, normal.z, d };
+        int k = 0;
+        for (int i = 0; i < 4; i++)
+            for (int j = i; j < 4; j++)
+                q.a[k++] = p[i] * p[j] * weight;
+        q.weight = weight;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric &other)
+    {
+        for (int i = 0; i < 10; i++)
+            a[i] += other.a[i];
+        weight += other.weight;
+        return *this;
+    }
+
+    // weighted mean squared distance of p to the planes
+    double error(const glm::dvec3 &p) const
+    {
+        double sum = a[0] * p.x * p.x + 2.0 * a[1] * p.x * p.y + 2.0 * a[2] * p.x * p.z + 2.0 * a[3] * p.x
+                   + a[4] * p.y * p.y + 2.0 * a[5] * p.y * p.z + 2.0 * a[6] * p.y
+                   + a[7] * p.z * p.z + 2.0 * a[8] * p.z
+                   + a[9];
+        return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+    }
+};
+
+// Edge collapse simplification onto existing vertices, so every level indexes the vertex
+// buffer of the full mesh. Open borders only collapse along themselves and vertices on
+// attribute seams (several vertices at one position) stay put, which keeps the outline
+// and the UV layout intact. Quadrics persist across simplify() calls, so levels made one
+// after the other report the error against the original surface.
+class Simplifier {
+public:
+    // positions is read with a stride in floats, like Bounds
+    Simplifier(const std::vector<unsigned int> &indices, const float *positions, std::size_t vertexCount, std::size_t strideFloats)
+        : m_indices(indices), m_positions(vertexCount), m_quadrics(vertexCount), m_kind(vertexCount, MANIFOLD)
+    {
+        for (std::size_t v = 0; v < vertexCount; v++)
+            m_positions[v] = glm::dvec3(positions[v * strideFloats], positions[v * strideFloats + 1], positions[v * strideFloats + 2]);
+        classifyVertices();
+        buildQuadrics();
+    }
+
+    const std::vector<unsigned int>& indices() const { return m_indices; }
+
+    // Collapses edges, cheapest first, until at most targetIndexCount indices are left or
+    // no collapse stays under errorLimit. Returns the largest error of any collapse so far.
+    float simplify(std::size_t targetIndexCount, float errorLimit)
+    {
+        double limit = static_cast<double>(errorLimit) * errorLimit;
+        while (m_indices.size() > targetIndexCount) {
+            std::size_t collapsed = collapsePass((m_indices.size() - targetIndexCount) / 3, limit);
+            if (collapsed == 0)
+                break;
+        }
+        return static_cast<float>(std::sqrt(m_maxError));
+    }
+
+private:
+    enum Kind : unsigned char { MANIFOLD, BORDER, LOCKED };
+
+    static constexpr double BORDER_WEIGHT = 10.0;
+
+    struct Collapse {
+        unsigned int from;
+        unsigned int to;
+        double error;
+    };
+
+    std::vector<unsigned int> m_indices;
+    std::vector<glm::dvec3> m_positions;
+    std::vector<Quadric> m_quadrics;
+    std::vector<unsigned char> m_kind;
+    std::vector<std::uint64_t> m_borderEdges; // sorted, as from << 32 | to
+    double m_maxError = 0.0;
+
+    static std::uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return static_cast<std::uint64_t>(a) << 32 | b;
+    }
+
+    bool isBorderEdge(unsigned int a, unsigned int b) const
+    {
+        return std::binary_search(m_borderEdges.begin(), m_borderEdges.end(), edgeKey(a, b))
+            || std::binary_search(m_borderEdges.begin(), m_borderEdges.end(), edgeKey(b, a));
+    }
+
+    // a directed edge without its reverse belongs to one triangle only
+    void findBorderEdges()
+    {
+        std::vector<std::uint64_t> edges;
+        edges.reserve(m_indices.size());
+        for (std::size_t t = 0; t + 2 < m_indices.size(); t += 3)
+            for (int k = 0; k < 3; k++)
+                edges.push_back(edgeKey(m_indices[t + k], m_indices[t + (k + 1) % 3]));
+        std::sort(edges.begin(), edges.end());
+        m_borderEdges.clear();
+        for (std::uint64_t edge : edges) {
+            std::uint64_t reverse = (edge << 32) | (edge >> 32);
+            if (!std::binary_search(edges.begin(), edges.end(), reverse))
+                m_borderEdges.push_back(edge);
+        }
+    }
+
+    void classifyVertices()
+    {
+        findBorderEdges();
+        for (std::uint64_t edge : m_borderEdges) {
+            m_kind[edge >> 32] = BORDER;
+            m_kind[edge & 0xFFFFFFFFu] = BORDER;
+        }
+
+        // seams: vertices that share a position with another vertex
+        struct PositionHash {
+            std::size_t operator()(const glm::dvec3 &p) const
+            {
+                std::uint64_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return static_cast<std::size_t>(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+            }
+        };
+        std::unordered_map<glm::dvec3, unsigned int, PositionHash> first;
+        for (unsigned int v = 0; v < m_positions.size(); v++) {
+            auto inserted = first.emplace(m_positions[v], v);
+            if (!inserted.second) {
+                m_kind[v] = LOCKED;
+                m_kind[inserted.first->second] = LOCKED;
+            }
+        }
+    }
+
+    void buildQuadrics()
+    {
+        for (std::size_t t = 0; t + 2 < m_indices.size(); t += 3) {
+            const glm::dvec3 &a = m_positions[m_indices[t]], &b = m_positions[m_indices[t + 1]], &c = m_positions[m_indices[t + 2]];
+            glm::dvec3 normal = glm::cross(b - a, c - a);
+            double area = glm::length(normal);
+            if (area == 0.0)
+                continue;
+            normal /= area;
+            Quadric q = Quadric::plane(normal, -glm::dot(normal, a), area * 0.5);
+            for (int k = 0; k < 3; k++)
+                m_quadrics[m_indices[t + k]] += q;
+
+            // borders also get a plane through the edge, perpendicular to the triangle, so
+            // collapses along them keep the outline
+            for (int k = 0; k < 3; k++) {
+                unsigned int from = m_indices[t + k], to = m_indices[t + (k + 1) % 3];
+                if (!std::binary_search(m_borderEdges.begin(), m_borderEdges.end(), edgeKey(from, to)))
+                    continue;
+                glm::dvec3 edge = m_positions[to] - m_positions[from];
+                double length = glm::length(edge);
+                if (length == 0.0)
+                    continue;
+                glm::dvec3 side = glm::normalize(glm::cross(edge, normal));
+                Quadric border = Quadric::plane(side, -glm::dot(side, m_positions[from]), length * length * BORDER_WEIGHT);
+                m_quadrics[from] += border;
+                m_quadrics[to] += border;
+            }
+        }
+    }
+
+    bool allowed(unsigned int from, unsigned int to) const
+    {
+        if (m_kind[from] == LOCKED)
+            return false;
+        if (m_kind[from] == BORDER)
+            return m_kind[to] == BORDER && isBorderEdge(from, to);
+        return true;
+    }
+
+    // moving from onto to must not turn any remaining triangle around from over
+    bool flips(unsigned int from, unsigned int to, const unsigned int *triangles, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; i++) {
+            const unsigned int *tri = &m_indices[triangles[i] * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+            glm::dvec3 before[3], after[3];
+            for (int k = 0; k < 3; k++) {
+                before[k] = m_positions[tri[k]];
+                after[k] = tri[k] == from ? m_positions[to] : before[k];
+            }
+            glm::dvec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::dvec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+            // also reject large turns, small ones add up over the passes
+            if (glm::dot(n0, n1) <= 0.25 * glm::length(n0) * glm::length(n1))
+                return true;
+        }
+        return false;
+    }
+
+    // one round of independent collapses, no vertex takes part in two; returns triangles removed
+    std::size_t collapsePass(std::size_t trianglesToRemove, double limit)
+    {
+        std::size_t vertexCount = m_positions.size();
+        std::size_t triangleCount = m_indices.size() / 3;
+        // collapses along a border leave new border edges behind
+        findBorderEdges();
+
+        // triangles around every vertex
+        std::vector<std::size_t> offsets(vertexCount + 1, 0);
+        for (unsigned int index : m_indices)
+            offsets[index + 1]++;
+        for (std::size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        std::vector<unsigned int> adjacency(m_indices.size());
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < m_indices.size(); i++)
+            adjacency[fill[m_indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+        std::vector<Collapse> collapses;
+        collapses.reserve(m_indices.size() * 2);
+        for (std::size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = m_indices[t * 3 + k], b = m_indices[t * 3 + (k + 1) % 3];
+                for (int direction = 0; direction < 2; direction++) {
+                    unsigned int from = direction ? b : a, to = direction ? a : b;
+                    if (!allowed(from, to))
+                        continue;
+                    Quadric q = m_quadrics[from];
+                    q += m_quadrics[to];
+                    double error = q.error(m_positions[to]);
+                    if (error <= limit)
+                        collapses.push_back(Collapse{ from, to, error });
+                }
+            }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) { return x.error < y.error; });
+
+        std::vector<unsigned int> remap(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+            remap[v] = v;
+        std::vector<bool> touched(vertexCount, false);
+        std::size_t removed = 0;
+        for (const Collapse &collapse : collapses) {
+            if (removed >= trianglesToRemove)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+            const unsigned int *around = &adjacency[offsets[collapse.from]];
+            std::size_t aroundCount = offsets[collapse.from + 1] - offsets[collapse.from];
+            if (flips(collapse.from, collapse.to, around, aroundCount))
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            m_quadrics[collapse.to] += m_quadrics[collapse.from];
+            m_maxError = std::max(m_maxError, collapse.error);
+            // the triangles around from changed shape, their corners sit this pass out
+            for (std::size_t i = 0; i < aroundCount; i++) {
+                const unsigned int *tri = &m_indices[around[i] * 3];
+                bool degenerate = false;
+                for (int k = 0; k < 3; k++) {
+                    touched[tri[k]] = true;
+                    degenerate |= tri[k] == collapse.to;
+                }
+                removed += degenerate;
+            }
+        }
+        if (removed == 0)
+            return 0;
+
+        std::size_t out = 0;
+        for (std::size_t t = 0; t < triangleCount; t++) {
+            unsigned int a = remap[m_indices[t * 3]], b = remap[m_indices[t * 3 + 1]], c = remap[m_indices[t * 3 + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            m_indices[out++] = a;
+            m_indices[out++] = b;
+            m_indices[out++] = c;
+        }
+        m_indices.resize(out);
+        return removed;
+    }
+};
+
+// Appends up to maxLevels - 1 simplified copies of the triangle list to indices, each about
+// half the triangles of the one before and cache optimized, and returns the level table,
+// level 0 being the indices as given. Stops early once a level would save under 10%.
+// errorLimit is an object-space distance.
+inline std::vector<MeshLod> buildLods(std::vector<unsigned int> &indices, const float *positions, std::size_t vertexCount,
+                                      std::size_t strideFloats, unsigned int maxLevels, float errorLimit)
+{
+    std::vector<MeshLod> lods(1);
+    lods[0].count = static_cast<unsigned int>(indices.size());
+    if (indices.size() < 3 * 8 || maxLevels < 2)
+        return lods;
+
+    Simplifier simplifier(indices, positions, vertexCount, strideFloats);
+    while (lods.size() < maxLevels) {
+        std::size_t target = lods.back().count / 6 * 3;
+        float error = simplifier.simplify(target, errorLimit);
+        std::size_t count = simplifier.indices().size();
+        if (count == 0 || count * 10 > lods.back().count * 9)
+            break;
+
+        std::vector<unsigned int> level = simplifier.indices();
+        optimizeVertexCache(level, vertexCount);
+        MeshLod lod;
+        lod.first = static_cast<unsigned int>(indices.size());
+        lod.count = static_cast<unsigned int>(count);
+        lod.error = error;
+        lods.push_back(lod);
+        indices.insert(indices.end(), level.begin(), level.end());
+    }
+    return lods;
+}
+
+}
+
+}
+
+#endif //PROJECT_BASE_MESHSIMPLIFIER_H
@@ -0,0 +1,145 @@
+#ifndef PROJECT_BASE_PIXELUPLOADRING_H
+#define PROJECT_BASE_PIXELUPLOADRING_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+namespace rg {
+
+// Ring of pixel unpack buffers for staging texture uploads. A slot is mapped for writing,
+// filled from any thread, then unmapped and used as the source of glTexImage* calls, which
+// return without waiting for the copy into the texture. A fence marks when the GPU is done
+// reading the slot and it can be mapped again.
+//
+// GL 3.3 has no persistently mapped buffers, so a slot is mapped unsynchronized each time
+// it is reused; the fence is what makes that safe.
+class PixelUploadRing {
+public:
+    explicit PixelUploadRing(int slots = 4)
+        : m_slots(slots), m_buffers(slots), m_state(slots)
+    {
+        glGenBuffers(m_slots, m_buffers.data());
+    }
+
+    ~PixelUploadRing()
+    {
+        release();
+    }
+
+    // deletes the buffers and fences, for rings outliving the GL context; no slot can be
+    // acquired afterwards
+    void release()
+    {
+        for (int i = 0; i < m_slots; i++)
+            if (m_state[i].fence)
+                glDeleteSync(m_state[i].fence);
+        if (m_slots)
+            glDeleteBuffers(m_slots, m_buffers.data());
+        m_slots = 0;
+        m_buffers.clear();
+        m_state.clear();
+    }
+
+    PixelUploadRing(const PixelUploadRing&) = delete;
+    PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+    // Maps a free slot of at least size bytes and returns its index, or -1 while every slot
+    // is mapped or still read by the GPU. With wait it blocks on the oldest GPU read
+    // instead, but still returns -1 if all slots are mapped.
+    int acquire(std::size_t size, unsigned char *&memory, bool wait = false)
+    {
+        int slot = findFree(wait);
+        if (slot < 0)
+            return -1;
+
+        Slot &state = m_state[slot];
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[slot]);
+        if (state.capacity < size) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            state.capacity = size;
+        }
+        memory = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!memory)
+            return -1;
+        state.mapped = true;
+        return slot;
+    }
+
+    // Unmaps a filled slot and binds it as GL_PIXEL_UNPACK_BUFFER, so the data pointer
+    // of the following glTexImage* calls is an offset into the slot.
+    void beginUpload(int slot)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[slot]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        m_state[slot].mapped = false;
+    }
+
+    // unbinds the slot, it is free again once the GPU has consumed the uploads
+    void endUpload(int slot)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        m_state[slot].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // gives back a mapped slot without uploading from it
+    void discard(int slot)
+    {
+        beginUpload(slot);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+private:
+    struct Slot {
+        GLsync fence = nullptr;
+        std::size_t capacity = 0;
+        bool mapped = false;
+    };
+
+    int m_slots;
+    std::vector<GLuint> m_buffers;
+    std::vector<Slot> m_state;
+    int m_next = 0;
+
+    int findFree(bool wait)
+    {
+        for (int i = 0; i < m_slots; i++) {
+            int slot = (m_next + i) % m_slots;
+            if (!m_state[slot].mapped && signaled(m_state[slot], false)) {
+                m_next = (slot + 1) % m_slots;
+                return slot;
+            }
+        }
+        if (!wait)
+            return -1;
+        // slots are taken in order, so the next one is the oldest
+        for (int i = 0; i < m_slots; i++) {
+            int slot = (m_next + i) % m_slots;
+            if (!m_state[slot].mapped && signaled(m_state[slot], true)) {
+                m_next = (slot + 1) % m_slots;
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    static bool signaled(Slot &state, bool wait)
+    {
+        if (!state.fence)
+            return true;
+        GLenum status = glClientWaitSync(state.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (wait && status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(state.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(state.fence);
+        state.fence = nullptr;
+        return true;
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_PIXELUPLOADRING_H
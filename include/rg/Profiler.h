@@ -0,0 +1,253 @@
+#ifndef PROJECT_BASE_PROFILER_H
+#define PROJECT_BASE_PROFILER_H
+
+#include <glad/glad.h>
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rg {
+
+// Rolling min/avg/p99 of the last samples of a pass, in milliseconds.
+struct TimingStats {
+    float min = 0.0f;
+    float avg = 0.0f;
+    float p99 = 0.0f;
+};
+
+// min, mean and 99th percentile of a set of timings
+inline TimingStats timingStats(std::vector<float> values)
+{
+    TimingStats stats;
+    if (values.empty())
+        return stats;
+    float sum = 0.0f;
+    for (float value : values)
+        sum += value;
+    stats.avg = sum / values.size();
+    stats.min = *std::min_element(values.begin(), values.end());
+    std::size_t p99 = (values.size() * 99) / 100;
+    std::nth_element(values.begin(), values.begin() + p99, values.end());
+    stats.p99 = values[p99];
+    return stats;
+}
+
+// Per-pass CPU and GPU timings. Every pass is bracketed by a pair of GL_TIMESTAMP
+// queries, one set per frame in flight, and read back a frame later when the
+// results are available, so profiling never stalls the pipeline.
+class Profiler {
+public:
+    // Times a pass from construction to the end of the enclosing block.
+    class Scope {
+    public:
+        Scope(Profiler &profiler, const char *name)
+            : m_profiler(profiler), m_pass(profiler.begin(name))
+        {}
+
+        ~Scope()
+        {
+            m_profiler.end(m_pass);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Profiler &m_profiler;
+        int m_pass;
+    };
+
+    // history is the number of samples per pass the rolling statistics cover
+    explicit Profiler(std::size_t history = 240)
+        : m_history(history)
+    {}
+
+    ~Profiler()
+    {
+        for (Pass &pass : m_passes)
+            glDeleteQueries(2 * FRAMES_IN_FLIGHT, &pass.queries[0][0]);
+    }
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // collects the GPU results of the frame whose queries are about to be reused
+    void beginFrame()
+    {
+        m_frame++;
+        int slot = m_frame % FRAMES_IN_FLIGHT;
+        for (Pass &pass : m_passes) {
+            if (!pass.pending[slot])
+                continue;
+            pass.pending[slot] = false;
+            GLint available = 0;
+            glGetQueryObjectiv(pass.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue; // dropped rather than waited for
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(pass.queries[slot][0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(pass.queries[slot][1], GL_QUERY_RESULT, &end);
+            pass.gpu.add(pass.frame[slot], (end - begin) / 1.0e6f);
+        }
+    }
+
+    int begin(const char *name)
+    {
+        int index = passIndex(name);
+        Pass &pass = m_passes[index];
+        int slot = m_frame % FRAMES_IN_FLIGHT;
+        glQueryCounter(pass.queries[slot][0], GL_TIMESTAMP);
+        pass.cpuBegin = std::chrono::steady_clock::now();
+        return index;
+    }
+
+    void end(int index)
+    {
+        Pass &pass = m_passes[index];
+        int slot = m_frame % FRAMES_IN_FLIGHT;
+        glQueryCounter(pass.queries[slot][1], GL_TIMESTAMP);
+        pass.pending[slot] = true;
+        pass.frame[slot] = m_frame;
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - pass.cpuBegin;
+        pass.cpu.add(m_frame, elapsed.count());
+    }
+
+    std::vector<std::string> passes() const
+    {
+        std::vector<std::string> names;
+        for (const Pass &pass : m_passes)
+            names.push_back(pass.name);
+        return names;
+    }
+
+    TimingStats cpuStats(const std::string &name) const { return find(name).cpu.stats(); }
+    TimingStats gpuStats(const std::string &name) const { return find(name).gpu.stats(); }
+
+    // ImGui window with one row per pass, between ImGui::NewFrame and ImGui::Render
+    void drawOverlay() const
+    {
+        ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing);
+        ImGui::Text("last %d frames, ms", static_cast<int>(m_history));
+        ImGui::Columns(7, "passes");
+        const char *headers[] = { "pass", "cpu min", "cpu avg", "cpu p99", "gpu min", "gpu avg", "gpu p99" };
+        for (const char *header : headers) {
+            ImGui::TextUnformatted(header);
+            ImGui::NextColumn();
+        }
+        ImGui::Separator();
+        for (const Pass &pass : m_passes) {
+            TimingStats cpu = pass.cpu.stats(), gpu = pass.gpu.stats();
+            ImGui::TextUnformatted(pass.name.c_str());
+            ImGui::NextColumn();
+            float values[] = { cpu.min, cpu.avg, cpu.p99, gpu.min, gpu.avg, gpu.p99 };
+            for (float value : values) {
+                ImGui::Text("%.3f", value);
+                ImGui::NextColumn();
+            }
+        }
+        ImGui::Columns(1);
+        ImGui::End();
+    }
+
+    // Writes every sample still in the history as frame,pass,cpu_ms,gpu_ms rows. A GPU
+    // time that was never read back is left empty.
+    bool writeCsv(const std::string &path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        file << "frame,pass,cpu_ms,gpu_ms\n";
+        for (const Pass &pass : m_passes) {
+            for (const Sample &cpu : pass.cpu.samples) {
+                file << cpu.frame << ',' << pass.name << ',' << cpu.milliseconds << ',';
+                for (const Sample &gpu : pass.gpu.samples) {
+                    if (gpu.frame == cpu.frame) {
+                        file << gpu.milliseconds;
+                        break;
+                    }
+                }
+                file << '\n';
+            }
+        }
+        return static_cast<bool>(file);
+    }
+
+private:
+    static const int FRAMES_IN_FLIGHT = 2;
+
+    struct Sample {
+        unsigned long frame = 0;
+        float milliseconds = 0.0f;
+    };
+
+    struct History {
+        std::vector<Sample> samples;
+        std::size_t capacity = 0;
+        std::size_t next = 0;
+
+        void add(unsigned long frame, float milliseconds)
+        {
+            Sample sample;
+            sample.frame = frame;
+            sample.milliseconds = milliseconds;
+            if (samples.size() < capacity) {
+                samples.push_back(sample);
+            } else {
+                samples[next] = sample;
+                next = (next + 1) % capacity;
+            }
+        }
+
+        TimingStats stats() const
+        {
+            std::vector<float> values;
+            values.reserve(samples.size());
+            for (const Sample &sample : samples)
+                values.push_back(sample.milliseconds);
+            return timingStats(values);
+        }
+    };
+
+    struct Pass {
+        std::string name;
+        GLuint queries[FRAMES_IN_FLIGHT][2];
+        bool pending[FRAMES_IN_FLIGHT] = {};
+        unsigned long frame[FRAMES_IN_FLIGHT] = {};
+        std::chrono::steady_clock::time_point cpuBegin;
+        History cpu;
+        History gpu;
+    };
+
+    std::size_t m_history;
+    std::vector<Pass> m_passes;
+    std::unordered_map<std::string, int> m_indices;
+    unsigned long m_frame = 0;
+
+    int passIndex(const char *name)
+    {
+        auto it = m_indices.find(name);
+        if (it != m_indices.end())
+            return it->second;
+        Pass pass;
+        pass.name = name;
+        pass.cpu.capacity = pass.gpu.capacity = m_history;
+        glGenQueries(2 * FRAMES_IN_FLIGHT, &pass.queries[0][0]);
+        m_passes.push_back(pass);
+        m_indices[name] = static_cast<int>(m_passes.size() - 1);
+        return static_cast<int>(m_passes.size() - 1);
+    }
+
+    const Pass& find(const std::string &name) const
+    {
+        return m_passes[m_indices.at(name)];
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_PROFILER_H
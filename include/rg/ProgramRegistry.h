@@ -0,0 +1,38 @@
+#ifndef PROJECT_BASE_PROGRAMREGISTRY_H
+#define PROJECT_BASE_PROGRAMREGISTRY_H
+
+#include <learnopengl/shader.h>
+#include <rg/FrameUniforms.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace rg {
+
+// Owns every linked program, keyed by (vertex path, fragment path, defines), so asking
+// for the same combination twice returns the already linked program instead of a copy.
+class ProgramRegistry {
+public:
+    Shader& get(const std::string &vertexPath, const std::string &fragmentPath, const std::string &defines = "")
+    {
+        std::string key = vertexPath + '\n' + fragmentPath + '\n' + defines;
+        auto it = m_programs.find(key);
+        if (it != m_programs.end())
+            return *it->second;
+
+        std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, defines));
+        bindUniformBlocks(shader->ID);
+        Shader &result = *shader;
+        m_programs.emplace(key, std::move(shader));
+        return result;
+    }
+
+    std::size_t size() const { return m_programs.size(); }
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<Shader>> m_programs;
+};
+
+}
+
+#endif //PROJECT_BASE_PROGRAMREGISTRY_H
@@ -0,0 +1,158 @@
+#ifndef PROJECT_BASE_REGRESSIONCAPTURE_H
+#define PROJECT_BASE_REGRESSIONCAPTURE_H
+
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <rg/FrameCapture.h>
+#include <rg/Image.h>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Renders a fixed list of shots, writes each one as a PNG and, given a directory of
+// golden images, compares them against it:
+//
+//     ./projekat --capture goldens                       record the goldens
+//     ./projekat --capture out --golden goldens [--tolerance 2]
+//
+// Each shot is rendered for a few frames before it is read back, so state that lags a
+// frame behind (pooled targets, instance buffers) has settled.
+class RegressionCapture {
+public:
+    struct Options {
+        bool enabled = false;
+        std::string output = "captures";
+        std::string golden;     // empty to only write the captures
+        int tolerance = 2;      // largest accepted difference of a channel
+    };
+
+    static Options parse(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--capture") == 0) {
+                options.enabled = true;
+                if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                    options.output = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+                options.golden = argv[++i];
+            else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+                options.tolerance = std::atoi(argv[++i]);
+        }
+        return options;
+    }
+
+    struct Shot {
+        std::string name;
+        glm::vec3 position;
+        glm::vec3 target;
+        std::function<void()> setup; // switches the render path the shot is taken with
+    };
+
+    static const int FRAMES_PER_SHOT = 3;
+
+    RegressionCapture(const Options &options, std::vector<Shot> shots)
+        : m_options(options), m_shots(std::move(shots))
+    {}
+
+    bool finished() const { return m_frame >= m_shots.size() * FRAMES_PER_SHOT; }
+
+    // call before rendering a frame
+    void beginFrame(Camera &camera)
+    {
+        const Shot &shot = m_shots[m_frame / FRAMES_PER_SHOT];
+        if (m_frame % FRAMES_PER_SHOT == 0 && shot.setup)
+            shot.setup();
+        camera.Position = shot.position;
+        camera.LookAt(shot.target);
+    }
+
+    // call once the frame is in the back buffer, before the swap
+    void endFrame(FrameCapture &capture, int width, int height)
+    {
+        if (m_frame % FRAMES_PER_SHOT == FRAMES_PER_SHOT - 1) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            glReadBuffer(GL_BACK);
+            int shot = static_cast<int>(m_frame / FRAMES_PER_SHOT);
+            if (!capture.read(width, height, shot)) {
+                collect(capture, true);
+                capture.read(width, height, shot);
+            }
+        }
+        collect(capture, false);
+        m_frame++;
+    }
+
+    // Waits for the reads still in flight. Returns whether every shot matched its golden
+    // image, or was written when there are no goldens.
+    bool finish(FrameCapture &capture)
+    {
+        while (capture.pending())
+            collect(capture, true);
+        std::cerr << m_shots.size() - m_failures << "/" << m_shots.size() << " shots "
+                  << (m_options.golden.empty() ? "written" : "match") << "\n";
+        return m_failures == 0;
+    }
+
+private:
+    Options m_options;
+    std::vector<Shot> m_shots;
+    std::size_t m_frame = 0;
+    std::size_t m_failures = 0;
+
+    void collect(FrameCapture &capture, bool wait)
+    {
+        Image image;
+        int shot;
+        while (capture.collect(image, shot, wait)) {
+            check(m_shots[shot], image);
+            wait = false;
+        }
+    }
+
+    void check(const Shot &shot, const Image &image)
+    {
+        mkdir(m_options.output.c_str(), 0755);
+        std::string path = m_options.output + "/" + shot.name + ".png";
+        if (!writePng(path, image)) {
+            std::cerr << shot.name << ": could not write " << path << "\n";
+            m_failures++;
+            return;
+        }
+        if (m_options.golden.empty())
+            return;
+
+        Image golden;
+        std::string goldenPath = m_options.golden + "/" + shot.name + ".png";
+        if (!loadImage(goldenPath, golden)) {
+            std::cerr << shot.name << ": missing golden image " << goldenPath << "\n";
+            m_failures++;
+            return;
+        }
+
+        Image diff;
+        ImageDiff result = compareImages(image, golden, m_options.tolerance, &diff);
+        if (!result.sizeMatches) {
+            std::cerr << shot.name << ": size " << image.width << "x" << image.height << " differs from the golden "
+                      << golden.width << "x" << golden.height << "\n";
+            m_failures++;
+        } else if (result.differingPixels > 0) {
+            std::cerr << shot.name << ": " << result.differingPixels << " pixels differ, max delta " << result.maxDelta << "\n";
+            writePng(m_options.output + "/" + shot.name + "_diff.png", diff);
+            m_failures++;
+        } else {
+            std::cerr << shot.name << ": ok, max delta " << result.maxDelta << "\n";
+        }
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_REGRESSIONCAPTURE_H
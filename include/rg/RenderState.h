@@ -0,0 +1,330 @@
+#ifndef PROJECT_BASE_RENDERSTATE_H
+#define PROJECT_BASE_RENDERSTATE_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+// Per-frame counts of the state setting calls RenderState tracks, and of those it dropped
+// because they would have set what was already set.
+struct RenderStateStats {
+    unsigned int calls = 0;
+    unsigned int elided = 0;
+};
+
+// Shadow copy of the GL state the renderer switches most: program, vertex array, texture
+// bindings per unit, framebuffers, and the depth, blend and cull state. Like GLCallCounter
+// it swaps the glad function pointers, so every caller goes through it, and calls that
+// would leave the state as it is never reach the driver. Installed after GLCallCounter,
+// the counter sees only the calls that get through.
+//
+// Everything starts out unknown, and deleting a bound object forgets the bindings it had,
+// so the copy never claims state the context doesn't have. GL calls made on other threads
+// or contexts would go unseen; the renderer makes them all on the main thread.
+class RenderState {
+public:
+    static RenderStateStats& frameStats()
+    {
+        static RenderStateStats stats;
+        return stats;
+    }
+
+    static RenderStateStats endFrame()
+    {
+        RenderStateStats last = frameStats();
+        frameStats() = RenderStateStats();
+        return last;
+    }
+
+    // call once, after gladLoadGLLoader and GLCallCounter::install
+    static void install()
+    {
+        static bool installed = false;
+        if (installed)
+            return;
+        installed = true;
+        forget();
+
+        useProgram() = glad_glUseProgram;
+        glad_glUseProgram = trackUseProgram;
+        bindVertexArray() = glad_glBindVertexArray;
+        glad_glBindVertexArray = trackBindVertexArray;
+        activeTexture() = glad_glActiveTexture;
+        glad_glActiveTexture = trackActiveTexture;
+        bindTexture() = glad_glBindTexture;
+        glad_glBindTexture = trackBindTexture;
+        bindFramebuffer() = glad_glBindFramebuffer;
+        glad_glBindFramebuffer = trackBindFramebuffer;
+        enable() = glad_glEnable;
+        glad_glEnable = trackEnable;
+        disable() = glad_glDisable;
+        glad_glDisable = trackDisable;
+        depthFunc() = glad_glDepthFunc;
+        glad_glDepthFunc = trackDepthFunc;
+        depthMask() = glad_glDepthMask;
+        glad_glDepthMask = trackDepthMask;
+        blendFunc() = glad_glBlendFunc;
+        glad_glBlendFunc = trackBlendFunc;
+        blendFuncSeparate() = glad_glBlendFuncSeparate;
+        glad_glBlendFuncSeparate = trackBlendFuncSeparate;
+        cullFace() = glad_glCullFace;
+        glad_glCullFace = trackCullFace;
+
+        deleteProgram() = glad_glDeleteProgram;
+        glad_glDeleteProgram = trackDeleteProgram;
+        deleteVertexArrays() = glad_glDeleteVertexArrays;
+        glad_glDeleteVertexArrays = trackDeleteVertexArrays;
+        deleteTextures() = glad_glDeleteTextures;
+        glad_glDeleteTextures = trackDeleteTextures;
+        deleteFramebuffers() = glad_glDeleteFramebuffers;
+        glad_glDeleteFramebuffers = trackDeleteFramebuffers;
+    }
+
+private:
+    enum : GLuint { UNKNOWN = 0xFFFFFFFFu };
+    enum { UNITS = 32, TARGETS = 4, CAPABILITIES = 3 };
+
+    struct State {
+        GLuint program;
+        GLuint vertexArray;
+        GLuint activeTexture;
+        GLuint textures[UNITS][TARGETS];
+        GLuint drawFramebuffer;
+        GLuint readFramebuffer;
+        GLuint capabilities[CAPABILITIES];
+        GLuint depthFunc;
+        GLuint depthMask;
+        GLuint blend[4]; // source and destination RGB, source and destination alpha
+        GLuint cullFace;
+    };
+
+    static State& state()
+    {
+        static State value;
+        return value;
+    }
+
+    static void forget()
+    {
+        State &s = state();
+        s.program = s.vertexArray = s.activeTexture = UNKNOWN;
+        for (auto &unit : s.textures)
+            for (GLuint &texture : unit)
+                texture = UNKNOWN;
+        s.drawFramebuffer = s.readFramebuffer = UNKNOWN;
+        for (GLuint &capability : s.capabilities)
+            capability = UNKNOWN;
+        s.depthFunc = s.depthMask = s.cullFace = UNKNOWN;
+        for (GLuint &factor : s.blend)
+            factor = UNKNOWN;
+    }
+
+    // counts the call and stores value; false, and counted as elided, if it was there already
+    static bool changes(GLuint &current, GLuint value)
+    {
+        frameStats().calls++;
+        if (current == value) {
+            frameStats().elided++;
+            return false;
+        }
+        current = value;
+        return true;
+    }
+
+    static int targetIndex(GLenum target)
+    {
+        switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_CUBE_MAP: return 1;
+        case GL_TEXTURE_2D_ARRAY: return 2;
+        case GL_TEXTURE_2D_MULTISAMPLE: return 3;
+        default: return -1;
+        }
+    }
+
+    static int capabilityIndex(GLenum cap)
+    {
+        switch (cap) {
+        case GL_DEPTH_TEST: return 0;
+        case GL_BLEND: return 1;
+        case GL_CULL_FACE: return 2;
+        default: return -1;
+        }
+    }
+
+    // the original entry points, or GLCallCounter's
+    static PFNGLUSEPROGRAMPROC& useProgram() { static PFNGLUSEPROGRAMPROC f; return f; }
+    static PFNGLBINDVERTEXARRAYPROC& bindVertexArray() { static PFNGLBINDVERTEXARRAYPROC f; return f; }
+    static PFNGLACTIVETEXTUREPROC& activeTexture() { static PFNGLACTIVETEXTUREPROC f; return f; }
+    static PFNGLBINDTEXTUREPROC& bindTexture() { static PFNGLBINDTEXTUREPROC f; return f; }
+    static PFNGLBINDFRAMEBUFFERPROC& bindFramebuffer() { static PFNGLBINDFRAMEBUFFERPROC f; return f; }
+    static PFNGLENABLEPROC& enable() { static PFNGLENABLEPROC f; return f; }
+    static PFNGLDISABLEPROC& disable() { static PFNGLDISABLEPROC f; return f; }
+    static PFNGLDEPTHFUNCPROC& depthFunc() { static PFNGLDEPTHFUNCPROC f; return f; }
+    static PFNGLDEPTHMASKPROC& depthMask() { static PFNGLDEPTHMASKPROC f; return f; }
+    static PFNGLBLENDFUNCPROC& blendFunc() { static PFNGLBLENDFUNCPROC f; return f; }
+    static PFNGLBLENDFUNCSEPARATEPROC& blendFuncSeparate() { static PFNGLBLENDFUNCSEPARATEPROC f; return f; }
+    static PFNGLCULLFACEPROC& cullFace() { static PFNGLCULLFACEPROC f; return f; }
+    static PFNGLDELETEPROGRAMPROC& deleteProgram() { static PFNGLDELETEPROGRAMPROC f; return f; }
+    static PFNGLDELETEVERTEXARRAYSPROC& deleteVertexArrays() { static PFNGLDELETEVERTEXARRAYSPROC f; return f; }
+    static PFNGLDELETETEXTURESPROC& deleteTextures() { static PFNGLDELETETEXTURESPROC f; return f; }
+    static PFNGLDELETEFRAMEBUFFERSPROC& deleteFramebuffers() { static PFNGLDELETEFRAMEBUFFERSPROC f; return f; }
+
+    static void APIENTRY trackUseProgram(GLuint program)
+    {
+        if (changes(state().program, program))
+            useProgram()(program);
+    }
+
+    static void APIENTRY trackBindVertexArray(GLuint array)
+    {
+        if (changes(state().vertexArray, array))
+            bindVertexArray()(array);
+    }
+
+    static void APIENTRY trackActiveTexture(GLenum texture)
+    {
+        if (changes(state().activeTexture, texture))
+            activeTexture()(texture);
+    }
+
+    static void APIENTRY trackBindTexture(GLenum target, GLuint texture)
+    {
+        int index = targetIndex(target);
+        GLuint unit = state().activeTexture - GL_TEXTURE0;
+        if (index >= 0 && state().activeTexture != UNKNOWN && unit < UNITS) {
+            if (changes(state().textures[unit][index], texture))
+                bindTexture()(target, texture);
+            return;
+        }
+        // the binding lands on a unit the copy doesn't know, so that unit could be any of them
+        if (index >= 0 && state().activeTexture == UNKNOWN)
+            for (auto &bindings : state().textures)
+                bindings[index] = UNKNOWN;
+        bindTexture()(target, texture);
+    }
+
+    static void APIENTRY trackBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        State &s = state();
+        if (target == GL_FRAMEBUFFER) {
+            frameStats().calls++;
+            if (s.drawFramebuffer == framebuffer && s.readFramebuffer == framebuffer) {
+                frameStats().elided++;
+                return;
+            }
+            s.drawFramebuffer = s.readFramebuffer = framebuffer;
+        } else if (target == GL_DRAW_FRAMEBUFFER) {
+            if (!changes(s.drawFramebuffer, framebuffer))
+                return;
+        } else if (target == GL_READ_FRAMEBUFFER) {
+            if (!changes(s.readFramebuffer, framebuffer))
+                return;
+        }
+        bindFramebuffer()(target, framebuffer);
+    }
+
+    static void APIENTRY trackEnable(GLenum cap)
+    {
+        int index = capabilityIndex(cap);
+        if (index < 0 || changes(state().capabilities[index], GL_TRUE))
+            enable()(cap);
+    }
+
+    static void APIENTRY trackDisable(GLenum cap)
+    {
+        int index = capabilityIndex(cap);
+        if (index < 0 || changes(state().capabilities[index], GL_FALSE))
+            disable()(cap);
+    }
+
+    static void APIENTRY trackDepthFunc(GLenum func)
+    {
+        if (changes(state().depthFunc, func))
+            depthFunc()(func);
+    }
+
+    static void APIENTRY trackDepthMask(GLboolean flag)
+    {
+        if (changes(state().depthMask, flag ? GL_TRUE : GL_FALSE))
+            depthMask()(flag);
+    }
+
+    static void APIENTRY trackBlendFunc(GLenum source, GLenum destination)
+    {
+        GLuint *blend = state().blend;
+        frameStats().calls++;
+        if (blend[0] == source && blend[1] == destination && blend[2] == source && blend[3] == destination) {
+            frameStats().elided++;
+            return;
+        }
+        blend[0] = blend[2] = source;
+        blend[1] = blend[3] = destination;
+        blendFunc()(source, destination);
+    }
+
+    static void APIENTRY trackBlendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha)
+    {
+        GLuint *blend = state().blend;
+        frameStats().calls++;
+        if (blend[0] == sourceRGB && blend[1] == destinationRGB && blend[2] == sourceAlpha && blend[3] == destinationAlpha) {
+            frameStats().elided++;
+            return;
+        }
+        blend[0] = sourceRGB;
+        blend[1] = destinationRGB;
+        blend[2] = sourceAlpha;
+        blend[3] = destinationAlpha;
+        blendFuncSeparate()(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+    }
+
+    static void APIENTRY trackCullFace(GLenum mode)
+    {
+        if (changes(state().cullFace, mode))
+            cullFace()(mode);
+    }
+
+    // GL unbinds deleted objects; forgetting them also covers a program deleted while in use,
+    // which stays current, and names handed out again for new objects
+    static void APIENTRY trackDeleteProgram(GLuint program)
+    {
+        if (state().program == program)
+            state().program = UNKNOWN;
+        deleteProgram()(program);
+    }
+
+    static void APIENTRY trackDeleteVertexArrays(GLsizei n, const GLuint *arrays)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            if (arrays[i] != 0 && state().vertexArray == arrays[i])
+                state().vertexArray = UNKNOWN;
+        deleteVertexArrays()(n, arrays);
+    }
+
+    static void APIENTRY trackDeleteTextures(GLsizei n, const GLuint *textures)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            for (auto &bindings : state().textures)
+                for (GLuint &texture : bindings)
+                    if (textures[i] != 0 && texture == textures[i])
+                        texture = UNKNOWN;
+        deleteTextures()(n, textures);
+    }
+
+    static void APIENTRY trackDeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+    {
+        for (GLsizei i = 0; i < n; i++) {
+            if (framebuffers[i] == 0)
+                continue;
+            if (state().drawFramebuffer == framebuffers[i])
+                state().drawFramebuffer = UNKNOWN;
+            if (state().readFramebuffer == framebuffers[i])
+                state().readFramebuffer = UNKNOWN;
+        }
+        deleteFramebuffers()(n, framebuffers);
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_RENDERSTATE_H
@@ -0,0 +1,263 @@
+#ifndef PROJECT_BASE_RENDERTARGETPOOL_H
+#define PROJECT_BASE_RENDERTARGETPOOL_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+
+namespace rg {
+
+// Every target is a texture, depth included, so one GLuint name identifies it.
+struct TargetFormat {
+    GLenum internalFormat = GL_RGBA8;
+    GLsizei samples = 0; // 0 for a single sampled texture
+
+    static TargetFormat texture(GLenum internalFormat)
+    {
+        TargetFormat format;
+        format.internalFormat = internalFormat;
+        return format;
+    }
+
+    static TargetFormat multisampled(GLenum internalFormat, GLsizei samples)
+    {
+        TargetFormat format;
+        format.internalFormat = internalFormat;
+        format.samples = samples;
+        return format;
+    }
+
+    bool isDepth() const
+    {
+        return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24
+            || internalFormat == GL_DEPTH_COMPONENT32F || hasStencil();
+    }
+
+    bool hasStencil() const
+    {
+        return internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+    }
+
+    bool operator==(const TargetFormat &other) const
+    {
+        return internalFormat == other.internalFormat && samples == other.samples;
+    }
+};
+
+// Owns the offscreen color and depth targets of the frame. Passes acquire a target
+// when they start writing it and release it after its last read, so targets of the
+// same format and size are shared between passes that never overlap. Targets follow
+// the output size times the render scale; a size change makes the old ones unused
+// and they are deleted at the next beginFrame().
+class RenderTargetPool {
+public:
+    RenderTargetPool() = default;
+
+    ~RenderTargetPool()
+    {
+        for (Target &target : m_targets)
+            destroy(target);
+    }
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // size of the default framebuffer the frame ends up in
+    void setOutputSize(int width, int height)
+    {
+        m_outputWidth = std::max(1, width);
+        m_outputHeight = std::max(1, height);
+    }
+
+    // internal resolution relative to the output, for dynamic resolution
+    void setRenderScale(float scale)
+    {
+        m_renderScale = std::max(0.1f, std::min(scale, 2.0f));
+    }
+
+    float renderScale() const { return m_renderScale; }
+    int outputWidth() const { return m_outputWidth; }
+    int outputHeight() const { return m_outputHeight; }
+    int width() const { return std::max(1, static_cast<int>(std::lround(m_outputWidth * m_renderScale))); }
+    int height() const { return std::max(1, static_cast<int>(std::lround(m_outputHeight * m_renderScale))); }
+
+    // Releases whatever the last frame left acquired and deletes targets (and the
+    // framebuffers using them) that were not used during the last frame.
+    void beginFrame()
+    {
+        m_frame++;
+        for (std::size_t i = 0; i < m_targets.size(); ) {
+            Target &target = m_targets[i];
+            target.inUse = false;
+            if (target.lastUsed + 1 < m_frame) {
+                destroy(target);
+                m_targets[i] = m_targets.back();
+                m_targets.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // a target at the internal resolution
+    GLuint acquire(const TargetFormat &format)
+    {
+        return acquire(format, width(), height());
+    }
+
+    GLuint acquire(const TargetFormat &format, int width, int height)
+    {
+        for (Target &target : m_targets) {
+            if (!target.inUse && target.format == format && target.width == width && target.height == height) {
+                target.inUse = true;
+                target.lastUsed = m_frame;
+                return target.name;
+            }
+        }
+
+        Target target;
+        target.format = format;
+        target.width = width;
+        target.height = height;
+        target.inUse = true;
+        target.lastUsed = m_frame;
+        create(target);
+        m_targets.push_back(target);
+        return target.name;
+    }
+
+    void release(GLuint name)
+    {
+        for (Target &target : m_targets)
+            if (target.name == name)
+                target.inUse = false;
+    }
+
+    // A framebuffer with the given color attachments, in draw buffer order, and an
+    // optional depth target. Framebuffers are cached per attachment set.
+    GLuint framebuffer(std::initializer_list<GLuint> colors, GLuint depth = 0)
+    {
+        // looked up several times a frame, so a hit compares in place without copying colors
+        for (Target &target : m_targets)
+            for (Framebuffer &framebuffer : target.framebuffers)
+                if (framebuffer.depth == depth && framebuffer.colors.size() == colors.size()
+                    && std::equal(colors.begin(), colors.end(), framebuffer.colors.begin()))
+                    return framebuffer.fbo;
+
+        std::vector<GLuint> colorList(colors);
+        Framebuffer framebuffer;
+        framebuffer.colors = colorList;
+        framebuffer.depth = depth;
+        glGenFramebuffers(1, &framebuffer.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+
+        std::vector<GLenum> drawBuffers;
+        for (std::size_t i = 0; i < colorList.size(); i++) {
+            const Target *target = find(colorList[i]);
+            GLenum textureTarget = target && target->format.samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, textureTarget, colorList[i], 0);
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+        }
+        glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+
+        if (depth) {
+            const Target *target = find(depth);
+            bool stencil = target && target->format.hasStencil();
+            GLenum textureTarget = target && target->format.samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+            glFramebufferTexture2D(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                                   textureTarget, depth, 0);
+        }
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Pooled framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // owned by the first attachment, so it goes away together with it
+        Target *owner = find(colorList.empty() ? depth : colorList[0]);
+        if (owner)
+            owner->framebuffers.push_back(framebuffer);
+        return framebuffer.fbo;
+    }
+
+    std::size_t size() const { return m_targets.size(); }
+
+private:
+    struct Framebuffer {
+        GLuint fbo = 0;
+        std::vector<GLuint> colors;
+        GLuint depth = 0;
+    };
+
+    struct Target {
+        GLuint name = 0;
+        TargetFormat format;
+        int width = 0;
+        int height = 0;
+        bool inUse = false;
+        unsigned long lastUsed = 0;
+        std::vector<Framebuffer> framebuffers;
+    };
+
+    std::vector<Target> m_targets;
+    unsigned long m_frame = 0;
+    int m_outputWidth = 1;
+    int m_outputHeight = 1;
+    float m_renderScale = 1.0f;
+
+    Target* find(GLuint name)
+    {
+        for (Target &target : m_targets)
+            if (target.name == name)
+                return &target;
+        return nullptr;
+    }
+
+    void create(Target &target)
+    {
+        const TargetFormat &format = target.format;
+        glGenTextures(1, &target.name);
+        if (format.samples > 0) {
+            glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, target.name);
+            glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, format.samples, format.internalFormat, target.width, target.height, GL_TRUE);
+            glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+        } else {
+            // no data is uploaded, the format/type pair only has to be compatible
+            GLenum pixelFormat = format.hasStencil() ? GL_DEPTH_STENCIL : format.isDepth() ? GL_DEPTH_COMPONENT : GL_RGBA;
+            GLenum pixelType = format.internalFormat == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8
+                             : format.internalFormat == GL_DEPTH32F_STENCIL8 ? GL_FLOAT_32_UNSIGNED_INT_24_8_REV : GL_FLOAT;
+            glBindTexture(GL_TEXTURE_2D, target.name);
+            glTexImage2D(GL_TEXTURE_2D, 0, format.internalFormat, target.width, target.height, 0, pixelFormat, pixelType, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // blur filters would otherwise sample repeated texels
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    }
+
+    void destroy(Target &target)
+    {
+        // framebuffers of other targets may still reference this one
+        for (Target &other : m_targets) {
+            for (std::size_t i = 0; i < other.framebuffers.size(); ) {
+                const Framebuffer &framebuffer = other.framebuffers[i];
+                bool uses = framebuffer.depth == target.name
+                        || std::find(framebuffer.colors.begin(), framebuffer.colors.end(), target.name) != framebuffer.colors.end();
+                if (uses) {
+                    glDeleteFramebuffers(1, &framebuffer.fbo);
+                    other.framebuffers.erase(other.framebuffers.begin() + i);
+                } else {
+                    i++;
+                }
+            }
+        }
+        glDeleteTextures(1, &target.name);
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_RENDERTARGETPOOL_H
@@ -0,0 +1,194 @@
+#ifndef PROJECT_BASE_SCENE_H
+#define PROJECT_BASE_SCENE_H
+
+#include <glm/glm.hpp>
+#include <rg/Bounds.h>
+#include <rg/Frustum.h>
+#include <vector>
+
+namespace rg {
+
+// A node of the scene graph. Nodes are stored in one array with parents always
+// before their children, so world matrices are resolved in a single forward pass.
+struct SceneNode {
+    glm::mat4 local = glm::mat4(1.0f);
+    glm::mat4 world = glm::mat4(1.0f);
+    int parent = -1;
+    unsigned batch = 0;    // what the node draws with, see Scene::addBatch
+    bool dirty = true;     // local changed since the last update
+    bool visible = true;
+};
+
+// Retained scene graph. Only nodes whose local transform (or an ancestor's) changed
+// get their world matrix recomputed, and the world matrices of visible nodes are
+// kept in a flat array grouped by batch, ready for InstanceBuffer::update.
+// Nodes outside the frustum passed to update() count as invisible.
+class Scene {
+public:
+    // Batches group nodes that are drawn together, e.g. one mesh with one material.
+    // Batch 0 is reserved for nodes that only carry a transform.
+    static const unsigned NO_BATCH = 0;
+
+    struct BatchRange {
+        unsigned first = 0;
+        unsigned count = 0;
+    };
+
+    Scene()
+        : m_ranges(1), m_batchBounds(1)
+    {}
+
+    // bounds are the object-space bounds of whatever the batch draws
+    unsigned addBatch(const Bounds &bounds = Bounds())
+    {
+        m_ranges.emplace_back();
+        m_batchBounds.push_back(bounds);
+        m_listDirty = true;
+        return static_cast<unsigned>(m_ranges.size() - 1);
+    }
+
+    int add(const glm::mat4 &local, unsigned batch = NO_BATCH, int parent = -1)
+    {
+        SceneNode node;
+        node.local = local;
+        node.parent = parent;
+        node.batch = batch;
+        m_nodes.push_back(node);
+        m_sphereX.push_back(0.0f);
+        m_sphereY.push_back(0.0f);
+        m_sphereZ.push_back(0.0f);
+        m_sphereRadius.push_back(0.0f);
+        m_inFrustum.push_back(1);
+        m_listDirty = true;
+        return static_cast<int>(m_nodes.size() - 1);
+    }
+
+    void setLocal(int node, const glm::mat4 &local)
+    {
+        m_nodes[node].local = local;
+        m_nodes[node].dirty = true;
+    }
+
+    void setVisible(int node, bool visible)
+    {
+        if (m_nodes[node].visible != visible) {
+            m_nodes[node].visible = visible;
+            m_listDirty = true;
+        }
+    }
+
+    const SceneNode& node(int node) const { return m_nodes[node]; }
+    std::size_t size() const { return m_nodes.size(); }
+
+    // Recomputes the stale world matrices and rebuilds the visible list if anything
+    // changed. Returns true when the batch ranges have new contents.
+    bool update()
+    {
+        return update(nullptr);
+    }
+
+    // Same as update(), additionally culling the nodes against the frustum. The tests
+    // run over all nodes at once and the drawn/culled counts go to Frustum::frameStats.
+    bool update(const Frustum &frustum)
+    {
+        return update(&frustum);
+    }
+
+    // world matrices of the visible nodes, grouped by batch
+    const std::vector<glm::mat4>& visibleWorlds() const { return m_visible; }
+    const BatchRange& batch(unsigned batch) const { return m_ranges[batch]; }
+    const glm::mat4* batchWorlds(unsigned batch) const { return m_visible.data() + m_ranges[batch].first; }
+
+private:
+    std::vector<SceneNode> m_nodes;
+    std::vector<unsigned char> m_moved;
+    std::vector<BatchRange> m_ranges;
+    std::vector<Bounds> m_batchBounds;
+    std::vector<glm::mat4> m_visible;
+    bool m_listDirty = true;
+
+    // world bounding spheres of the nodes, one array per component for the batched test
+    std::vector<float> m_sphereX, m_sphereY, m_sphereZ, m_sphereRadius;
+    std::vector<unsigned char> m_inFrustum, m_cullResult;
+
+    bool update(const Frustum *frustum)
+    {
+        bool moved = false;
+        m_moved.assign(m_nodes.size(), 0);
+        for (std::size_t i = 0; i < m_nodes.size(); i++) {
+            SceneNode &node = m_nodes[i];
+            bool parentMoved = node.parent >= 0 && m_moved[node.parent];
+            if (!node.dirty && !parentMoved)
+                continue;
+            node.world = node.parent >= 0 ? m_nodes[node.parent].world * node.local : node.local;
+            node.dirty = false;
+            m_moved[i] = 1;
+            moved = true;
+
+            glm::vec4 sphere = m_batchBounds[node.batch].worldSphere(node.world);
+            m_sphereX[i] = sphere.x;
+            m_sphereY[i] = sphere.y;
+            m_sphereZ[i] = sphere.z;
+            m_sphereRadius[i] = sphere.w;
+        }
+
+        if (frustum)
+            moved |= cull(*frustum);
+
+        if (!moved && !m_listDirty)
+            return false;
+        rebuildVisible();
+        m_listDirty = false;
+        return true;
+    }
+
+    // returns true if any node entered or left the frustum
+    bool cull(const Frustum &frustum)
+    {
+        m_cullResult.resize(m_nodes.size());
+        frustum.intersects(m_sphereX.data(), m_sphereY.data(), m_sphereZ.data(), m_sphereRadius.data(),
+                           m_nodes.size(), m_cullResult.data());
+
+        bool changed = false;
+        CullStats &stats = Frustum::frameStats();
+        for (std::size_t i = 0; i < m_nodes.size(); i++) {
+            if (m_nodes[i].batch == NO_BATCH || !m_nodes[i].visible)
+                continue;
+            if (m_cullResult[i])
+                stats.drawn++;
+            else
+                stats.culled++;
+            changed |= m_cullResult[i] != m_inFrustum[i];
+        }
+        m_inFrustum.swap(m_cullResult);
+        return changed;
+    }
+
+    // counting sort of the visible nodes by batch
+    void rebuildVisible()
+    {
+        for (BatchRange &range : m_ranges)
+            range = BatchRange();
+        for (std::size_t i = 0; i < m_nodes.size(); i++)
+            if (m_nodes[i].visible && m_nodes[i].batch != NO_BATCH && m_inFrustum[i])
+                m_ranges[m_nodes[i].batch].count++;
+
+        unsigned first = 0;
+        for (BatchRange &range : m_ranges) {
+            range.first = first;
+            first += range.count;
+        }
+
+        m_visible.resize(first);
+        std::vector<unsigned> cursor(m_ranges.size());
+        for (std::size_t i = 0; i < m_ranges.size(); i++)
+            cursor[i] = m_ranges[i].first;
+        for (std::size_t i = 0; i < m_nodes.size(); i++)
+            if (m_nodes[i].visible && m_nodes[i].batch != NO_BATCH && m_inFrustum[i])
+                m_visible[cursor[m_nodes[i].batch]++] = m_nodes[i].world;
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_SCENE_H
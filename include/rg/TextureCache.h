@@ -0,0 +1,174 @@
+#ifndef PROJECT_BASE_TEXTURECACHE_H
+#define PROJECT_BASE_TEXTURECACHE_H
+
+#include <glad/glad.h>
+#include <rg/TextureLoader.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rg {
+
+// Lifetime counters of the TextureCache, and what it holds right now.
+struct TextureCacheStats {
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    unsigned int textures = 0;
+    unsigned int unreferenced = 0;
+    std::size_t residentBytes = 0;
+};
+
+// Process-wide, reference counted cache of the textures TextureLoader loads, so an image
+// used by several Models, Texture2Ds or loadTexture calls is decoded and uploaded once.
+// Entries are keyed by the canonical path of the file, of all files for cube maps and
+// arrays, and the texture target, which fixes the sampling parameters TextureLoader sets up.
+//
+// A texture whose last reference is released stays cached, in case it is asked for again,
+// until the unreferenced ones take more than unreferencedBudget bytes; the oldest go first.
+class TextureCache {
+public:
+    static TextureCache& instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    std::size_t unreferencedBudget = 64 << 20;
+
+    // repeating, trilinear filtered texture with mipmaps; every acquire needs a release
+    GLuint acquire2D(const std::string &path)
+    {
+        return acquire(GL_TEXTURE_2D, canonicalPath(path), [&path]() { return TextureLoader::instance().load2D(path); });
+    }
+
+    // faces in the +X, -X, +Y, -Y, +Z, -Z order of the cube map targets
+    GLuint acquireCubemap(const std::vector<std::string> &faces)
+    {
+        std::string key;
+        for (const std::string &face : faces)
+            key += canonicalPath(face) + '\n';
+        return acquire(GL_TEXTURE_CUBE_MAP, key, [&faces]() { return TextureLoader::instance().loadCubemap(faces); });
+    }
+
+    // a GL_TEXTURE_2D_ARRAY with one layer per image, see TextureLoader::loadArray
+    GLuint acquireArray(const std::vector<std::string> &layers)
+    {
+        std::string key;
+        for (const std::string &layer : layers)
+            key += canonicalPath(layer) + '\n';
+        return acquire(GL_TEXTURE_2D_ARRAY, key, [&layers]() { return TextureLoader::instance().loadArray(layers); });
+    }
+
+    void release(GLuint texture)
+    {
+        auto found = m_byTexture.find(texture);
+        if (found == m_byTexture.end())
+            return;
+        Entry &entry = m_entries.at(found->second);
+        if (entry.references == 0 || --entry.references > 0)
+            return;
+        entry.unused = m_unused.insert(m_unused.end(), found->second);
+        trim(unreferencedBudget);
+    }
+
+    // deletes every texture nothing references, e.g. before the GL context goes away
+    void evictUnreferenced()
+    {
+        trim(0);
+    }
+
+    TextureCacheStats stats() const
+    {
+        TextureCacheStats stats = m_stats;
+        stats.textures = static_cast<unsigned int>(m_entries.size());
+        stats.unreferenced = static_cast<unsigned int>(m_unused.size());
+        for (const auto &entry : m_entries)
+            stats.residentBytes += TextureLoader::instance().residentBytes(entry.second.texture);
+        return stats;
+    }
+
+private:
+    struct Key {
+        GLenum target;
+        std::string path;
+
+        bool operator==(const Key &other) const { return target == other.target && path == other.path; }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const
+        {
+            return std::hash<std::string>()(key.path) ^ (static_cast<std::size_t>(key.target) * 0x9E3779B9u);
+        }
+    };
+
+    struct Entry {
+        GLuint texture = 0;
+        unsigned int references = 0;
+        std::list<Key>::iterator unused; // position in m_unused while references is 0
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> m_entries;
+    std::unordered_map<GLuint, Key> m_byTexture;
+    std::list<Key> m_unused; // least recently released first
+    TextureCacheStats m_stats;
+
+    TextureCache() = default;
+
+    template <typename Load>
+    GLuint acquire(GLenum target, const std::string &path, Load load)
+    {
+        Key key{ target, path };
+        auto found = m_entries.find(key);
+        if (found != m_entries.end()) {
+            m_stats.hits++;
+            Entry &entry = found->second;
+            if (entry.references++ == 0)
+                m_unused.erase(entry.unused);
+            return entry.texture;
+        }
+
+        m_stats.misses++;
+        Entry entry;
+        entry.texture = load();
+        entry.references = 1;
+        m_entries.emplace(key, entry);
+        m_byTexture.emplace(entry.texture, key);
+        return entry.texture;
+    }
+
+    // deletes unreferenced textures, oldest first, until they take at most budget bytes
+    void trim(std::size_t budget)
+    {
+        std::size_t unusedBytes = 0;
+        for (const Key &key : m_unused)
+            unusedBytes += TextureLoader::instance().residentBytes(m_entries.at(key).texture);
+        while (!m_unused.empty() && (unusedBytes > budget || budget == 0)) {
+            auto found = m_entries.find(m_unused.front());
+            GLuint texture = found->second.texture;
+            unusedBytes -= std::min(unusedBytes, TextureLoader::instance().residentBytes(texture));
+            TextureLoader::instance().destroy(texture);
+            m_byTexture.erase(texture);
+            m_entries.erase(found);
+            m_unused.pop_front();
+        }
+    }
+
+    // the same file reached through different relative paths or links shares an entry
+    static std::string canonicalPath(const std::string &path)
+    {
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved))
+            return resolved;
+        return path;
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_TEXTURECACHE_H
@@ -0,0 +1,83 @@
+#ifndef PROJECT_BASE_TEXTURECONTAINER_H
+#define PROJECT_BASE_TEXTURECONTAINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Layout of the .rgtx files written by tools/texture_baker.cpp: a header, one entry per
+// mip level, then the block compressed levels back to back. Baked files sit next to the
+// source image, e.g. table.jpg.rgtx, and are used instead of it when they are newer.
+namespace rgtx {
+
+const char MAGIC[4] = { 'R', 'G', 'T', 'X' };
+const std::uint32_t VERSION = 2; // 2: BC5 normal maps, which were BC1 before
+
+enum Codec : std::uint32_t {
+    BC1 = 1, // RGB, 8 bytes per 4x4 block (S3TC DXT1)
+    BC3 = 2, // RGBA, 16 bytes per block (S3TC DXT5)
+    BC4 = 3, // single channel, 8 bytes per block (RGTC1)
+    BC5 = 4  // two channels, the x and y of normal maps, 16 bytes per block (RGTC2)
+};
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t codec;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t levels;
+};
+
+struct Level {
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t offset; // from the start of the file
+    std::uint64_t size;
+};
+
+inline std::size_t blockBytes(std::uint32_t codec)
+{
+    return codec == BC3 || codec == BC5 ? 16 : 8;
+}
+
+inline std::size_t levelBytes(std::uint32_t codec, std::uint32_t width, std::uint32_t height)
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * blockBytes(codec);
+}
+
+inline std::string bakedPath(const std::string &source)
+{
+    return source + ".rgtx";
+}
+
+// Checks the header and level table against the file size; fills levels on success.
+inline bool parse(const unsigned char *data, std::size_t size, Header &header, std::vector<Level> &levels)
+{
+    if (size < sizeof(Header))
+        return false;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION)
+        return false;
+    if (header.codec < BC1 || header.codec > BC5 || header.levels == 0 || header.levels > 32)
+        return false;
+    if (size < sizeof(Header) + header.levels * sizeof(Level))
+        return false;
+
+    levels.resize(header.levels);
+    std::memcpy(levels.data(), data + sizeof(Header), header.levels * sizeof(Level));
+    for (const Level &level : levels)
+        if (level.offset + level.size > size || level.size != levelBytes(header.codec, level.width, level.height))
+            return false;
+    return true;
+}
+
+}
+
+}
+
+#endif //PROJECT_BASE_TEXTURECONTAINER_H
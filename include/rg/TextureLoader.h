@@ -0,0 +1,439 @@
+#ifndef PROJECT_BASE_TEXTURELOADER_H
+#define PROJECT_BASE_TEXTURELOADER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <rg/ThreadPool.h>
+#include <rg/PixelUploadRing.h>
+#include <rg/MappedFile.h>
+#include <rg/TextureContainer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// S3TC is an extension to GL 3.3 rather than core, so glad leaves these out
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace rg {
+
+// Decodes image files on a thread pool and uploads them on the GL thread as they finish.
+// load2D and loadCubemap return a texture name right away, holding a 1x1 grey placeholder
+// until poll() replaces it with the decoded image, so the files are decoded in parallel
+// while the rest of the scene loads.
+//
+// Decoded pixels are copied into a PixelUploadRing slot by a worker as well, and the
+// texture is specified from that buffer, so the driver doesn't copy the image on the main
+// thread. poll() stages at most UPLOAD_BUDGET bytes a frame to keep uploads from hitching.
+//
+// An image with an up to date .rgtx file baked by tools/texture_baker.cpp next to it is
+// memory mapped instead of decoded, and its compressed mip levels are uploaded as they are.
+class TextureLoader {
+public:
+    static TextureLoader& instance()
+    {
+        static TextureLoader loader;
+        return loader;
+    }
+
+    // repeating, trilinear filtered texture with mipmaps
+    GLuint load2D(const std::string &path)
+    {
+        Job job;
+        job.target = GL_TEXTURE_2D;
+        glGenTextures(1, &job.texture);
+        glBindTexture(GL_TEXTURE_2D, job.texture);
+        uploadPlaceholder(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        job.faces.push_back(decode(path, true));
+        m_jobs.push_back(std::move(job));
+        return m_jobs.back().texture;
+    }
+
+    // faces in the +X, -X, +Y, -Y, +Z, -Z order of the cube map targets
+    GLuint loadCubemap(const std::vector<std::string> &faces)
+    {
+        Job job;
+        job.target = GL_TEXTURE_CUBE_MAP;
+        glGenTextures(1, &job.texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, job.texture);
+        for (unsigned int i = 0; i < 6; i++)
+            uploadPlaceholder(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        for (const std::string &face : faces)
+            job.faces.push_back(decode(face, false));
+        m_jobs.push_back(std::move(job));
+        return m_jobs.back().texture;
+    }
+
+    // One GL_TEXTURE_2D_ARRAY layer per image, set up like load2D. The images must all be
+    // the same size; they are decoded, not read from baked files, and stored as RGBA8.
+    GLuint loadArray(const std::vector<std::string> &layers)
+    {
+        Job job;
+        job.target = GL_TEXTURE_2D_ARRAY;
+        glGenTextures(1, &job.texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, job.texture);
+        std::vector<unsigned char> grey(layers.size() * 4, 128);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, 1, 1, static_cast<GLsizei>(layers.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, grey.data());
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+        for (const std::string &layer : layers)
+            job.faces.push_back(decode(layer, true, false));
+        m_jobs.push_back(std::move(job));
+        return m_jobs.back().texture;
+    }
+
+    // Uploads every texture whose images have been decoded. Call on the GL thread, once a
+    // frame; returns the number of textures uploaded.
+    unsigned int poll()
+    {
+        return upload(false);
+    }
+
+    // blocks until every requested texture is uploaded
+    void finish()
+    {
+        upload(true);
+    }
+
+    // drops a pending upload, for textures deleted before their image arrived
+    void cancel(GLuint texture)
+    {
+        for (std::size_t i = 0; i < m_jobs.size(); i++) {
+            if (m_jobs[i].texture != texture)
+                continue;
+            if (m_jobs[i].slot >= 0) {
+                m_jobs[i].copy.wait(); // the worker may still be writing into the slot
+                m_staging.discard(m_jobs[i].slot);
+            }
+            m_jobs.erase(m_jobs.begin() + i);
+            return;
+        }
+    }
+
+    std::size_t pending() const { return m_jobs.size(); }
+
+    // drops the pending uploads and frees the staging buffers; the loader lives until static
+    // destruction, so call this while the GL context is still current
+    void shutdown()
+    {
+        while (!m_jobs.empty())
+            cancel(m_jobs.back().texture);
+        m_staging.release();
+    }
+
+    // cancels a pending upload and deletes the texture
+    void destroy(GLuint texture)
+    {
+        cancel(texture);
+        m_residentBytes.erase(texture);
+        glDeleteTextures(1, &texture);
+    }
+
+    // video memory taken by an uploaded texture and its mipmaps, 0 while it is a placeholder
+    std::size_t residentBytes(GLuint texture) const
+    {
+        auto found = m_residentBytes.find(texture);
+        return found != m_residentBytes.end() ? found->second : 0;
+    }
+
+private:
+    struct Decoded {
+        std::string path;
+        std::shared_ptr<const unsigned char> data;
+        int width = 0;
+        int height = 0;
+        int components = 0;
+        // baked images: the codec and the levels, with offsets relative to data
+        std::uint32_t codec = 0;
+        std::vector<rgtx::Level> levels;
+    };
+
+    struct Job {
+        GLuint texture = 0;
+        GLenum target = GL_TEXTURE_2D;
+        std::vector<std::future<Decoded>> faces;
+        // once decoded, the images and their offsets in the staging slot being filled
+        std::vector<Decoded> images;
+        std::vector<std::size_t> offsets;
+        int slot = -1;
+        std::future<void> copy;
+    };
+
+    static const std::size_t UPLOAD_BUDGET = 32 << 20;
+
+    ThreadPool m_pool;
+    PixelUploadRing m_staging;
+    std::vector<Job> m_jobs;
+    std::unordered_map<GLuint, std::size_t> m_residentBytes;
+    bool m_s3tc = false;
+
+    TextureLoader()
+    {
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions; i++)
+            if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_EXT_texture_compression_s3tc") == 0)
+                m_s3tc = true;
+    }
+
+    // with mipmaps false only the base level of a baked file is used
+    std::future<Decoded> decode(const std::string &path, bool mipmaps, bool baked = true)
+    {
+        bool s3tc = m_s3tc;
+        return m_pool.submit([path, mipmaps, baked, s3tc]() {
+            Decoded image;
+            image.path = path;
+            if (baked && loadBaked(path, s3tc, image)) {
+                if (!mipmaps)
+                    image.levels.resize(1);
+                return image;
+            }
+            unsigned char *data = stbi_load(path.c_str(), &image.width, &image.height, &image.components, 0);
+            if (data)
+                image.data = std::shared_ptr<const unsigned char>(data, stbi_image_free);
+            return image;
+        });
+    }
+
+    static bool loadBaked(const std::string &path, bool s3tc, Decoded &image)
+    {
+        std::string baked = rgtx::bakedPath(path);
+        long bakedTime = MappedFile::modificationTime(baked);
+        if (bakedTime == 0 || bakedTime < MappedFile::modificationTime(path))
+            return false;
+
+        auto file = std::make_shared<MappedFile>(baked);
+        rgtx::Header header;
+        std::vector<rgtx::Level> levels;
+        if (!file->valid() || !rgtx::parse(file->data(), file->size(), header, levels))
+            return false;
+        // RGTC is core, S3TC an extension
+        if ((header.codec == rgtx::BC1 || header.codec == rgtx::BC3) && !s3tc)
+            return false;
+
+        // the levels are stored back to back, rebase them onto the first one
+        std::uint64_t start = levels[0].offset;
+        for (rgtx::Level &level : levels)
+            level.offset -= start;
+        image.data = std::shared_ptr<const unsigned char>(file, file->data() + start);
+        image.width = header.width;
+        image.height = header.height;
+        image.codec = header.codec;
+        image.levels = levels;
+        return true;
+    }
+
+    static GLenum compressedFormat(std::uint32_t codec)
+    {
+        if (codec == rgtx::BC1)
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        if (codec == rgtx::BC3)
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        if (codec == rgtx::BC5)
+            return GL_COMPRESSED_RG_RGTC2;
+        return GL_COMPRESSED_RED_RGTC1;
+    }
+
+    static void uploadPlaceholder(GLenum target)
+    {
+        const unsigned char grey[] = { 128, 128, 128, 255 };
+        glTexImage2D(target, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    }
+
+    static GLenum format(int components)
+    {
+        if (components == 1)
+            return GL_RED;
+        if (components == 3)
+            return GL_RGB;
+        return GL_RGBA;
+    }
+
+    static bool ready(const Job &job)
+    {
+        if (!job.images.empty())
+            return true; // already taken from the futures
+        for (const std::future<Decoded> &face : job.faces)
+            if (face.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return false;
+        return true;
+    }
+
+    static std::size_t byteSize(const Decoded &image)
+    {
+        if (image.codec) {
+            const rgtx::Level &last = image.levels.back();
+            return last.offset + last.size;
+        }
+        return static_cast<std::size_t>(image.width) * image.height * image.components;
+    }
+
+    unsigned int upload(bool wait)
+    {
+        unsigned int uploaded = 0;
+        do {
+            // specify the textures whose staging copy is done
+            for (std::size_t i = 0; i < m_jobs.size();) {
+                Job &job = m_jobs[i];
+                if (job.slot < 0 || (!wait && job.copy.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+                    i++;
+                    continue;
+                }
+                job.copy.get();
+                specify(job);
+                m_jobs.erase(m_jobs.begin() + i);
+                uploaded++;
+            }
+
+            // hand decoded images to the workers to copy into free staging slots
+            std::size_t staged = 0;
+            for (std::size_t i = 0; i < m_jobs.size();) {
+                Job &job = m_jobs[i];
+                if (job.slot >= 0 || (!wait && (!ready(job) || staged >= UPLOAD_BUDGET))) {
+                    i++;
+                    continue;
+                }
+                if (job.images.empty())
+                    for (std::future<Decoded> &face : job.faces)
+                        job.images.push_back(face.get());
+
+                std::size_t size = 0;
+                for (const Decoded &image : job.images) {
+                    job.offsets.push_back(size);
+                    size += byteSize(image);
+                }
+                if (size == 0) {
+                    // nothing decoded, the placeholder stays
+                    for (const Decoded &image : job.images)
+                        std::cout << "Texture failed to load at path: " << image.path << std::endl;
+                    m_jobs.erase(m_jobs.begin() + i);
+                    continue;
+                }
+
+                unsigned char *memory = nullptr;
+                job.slot = m_staging.acquire(size, memory, wait);
+                if (job.slot < 0) {
+                    job.offsets.clear();
+                    break;
+                }
+                std::vector<Decoded> images = job.images;
+                std::vector<std::size_t> offsets = job.offsets;
+                job.copy = m_pool.submit([images, offsets, memory]() {
+                    for (std::size_t face = 0; face < images.size(); face++)
+                        if (images[face].data)
+                            std::memcpy(memory + offsets[face], images[face].data.get(), byteSize(images[face]));
+                });
+                staged += size;
+                i++;
+            }
+        } while (wait && !m_jobs.empty());
+        return uploaded;
+    }
+
+    void specify(Job &job)
+    {
+        glBindTexture(job.target, job.texture);
+        if (job.target == GL_TEXTURE_2D_ARRAY) {
+            specifyArray(job);
+            return;
+        }
+        m_staging.beginUpload(job.slot);
+        std::size_t &resident = m_residentBytes[job.texture];
+        resident = 0;
+        for (std::size_t face = 0; face < job.images.size(); face++) {
+            const Decoded &image = job.images[face];
+            if (!image.data) {
+                std::cout << "Texture failed to load at path: " << image.path << std::endl;
+                continue;
+            }
+            GLenum target = job.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : job.target;
+            if (image.codec) {
+                for (std::size_t level = 0; level < image.levels.size(); level++)
+                    glCompressedTexImage2D(target, level, compressedFormat(image.codec),
+                                           image.levels[level].width, image.levels[level].height, 0, image.levels[level].size,
+                                           reinterpret_cast<const void*>(job.offsets[face] + image.levels[level].offset));
+                if (job.target == GL_TEXTURE_2D)
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - 1));
+                resident += byteSize(image);
+                continue;
+            }
+            GLenum dataFormat = format(image.components);
+            glTexImage2D(target, 0, dataFormat, image.width, image.height, 0, dataFormat, GL_UNSIGNED_BYTE,
+                         reinterpret_cast<const void*>(job.offsets[face]));
+            // drivers pad RGB to four bytes a texel, mipmaps add a third
+            std::size_t bytes = static_cast<std::size_t>(image.width) * image.height * (image.components == 3 ? 4 : image.components);
+            if (job.target == GL_TEXTURE_2D) {
+                glGenerateMipmap(GL_TEXTURE_2D);
+                bytes += bytes / 3;
+            }
+            resident += bytes;
+        }
+        m_staging.endUpload(job.slot);
+    }
+
+    // the layers take the size of the first decoded image, the ones that differ stay grey
+    void specifyArray(const Job &job)
+    {
+        const Decoded *first = nullptr;
+        for (const Decoded &image : job.images)
+            if (image.data && !first)
+                first = &image;
+        if (!first) {
+            m_staging.beginUpload(job.slot);
+            m_staging.endUpload(job.slot);
+            return;
+        }
+        // storage and the grey fill are specified before the staging slot is bound
+        GLsizei layers = static_cast<GLsizei>(job.images.size());
+        std::vector<unsigned char> grey(static_cast<std::size_t>(first->width) * first->height * 4, 128);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, first->width, first->height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        for (GLsizei layer = 0; layer < layers; layer++) {
+            const Decoded &image = job.images[layer];
+            if (image.data && image.width == first->width && image.height == first->height)
+                continue;
+            std::cout << "Texture array layer " << layer << " failed to load or has another size: " << image.path << std::endl;
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, first->width, first->height, 1, GL_RGBA, GL_UNSIGNED_BYTE, grey.data());
+        }
+        m_staging.beginUpload(job.slot);
+        for (GLsizei layer = 0; layer < layers; layer++) {
+            const Decoded &image = job.images[layer];
+            if (image.data && image.width == first->width && image.height == first->height)
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.width, image.height, 1, format(image.components), GL_UNSIGNED_BYTE,
+                                reinterpret_cast<const void*>(job.offsets[layer]));
+        }
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        m_staging.endUpload(job.slot);
+        std::size_t bytes = static_cast<std::size_t>(first->width) * first->height * 4 * layers;
+        m_residentBytes[job.texture] = bytes + bytes / 3;
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_TEXTURELOADER_H
@@ -0,0 +1,91 @@
+#ifndef PROJECT_BASE_THREADPOOL_H
+#define PROJECT_BASE_THREADPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace rg {
+
+// Fixed set of worker threads running submitted jobs in FIFO order. Jobs must not touch
+// GL, the context belongs to the main thread.
+class ThreadPool {
+public:
+    // by default one worker per core, leaving one core to the main thread
+    explicit ThreadPool(unsigned int threads = defaultThreadCount())
+    {
+        for (unsigned int i = 0; i < threads; i++)
+            m_workers.emplace_back([this]() { work(); });
+    }
+
+    // finishes the queued jobs before joining
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &worker : m_workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> submit(F job)
+    {
+        using Result = typename std::result_of<F()>::type;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(job));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push([task]() { (*task)(); });
+        }
+        m_wake.notify_one();
+        return result;
+    }
+
+    std::size_t size() const { return m_workers.size(); }
+
+    static unsigned int defaultThreadCount()
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return std::max(1u, cores > 1 ? cores - 1 : 1u);
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    void work()
+    {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+                if (m_jobs.empty())
+                    return;
+                job = std::move(m_jobs.front());
+                m_jobs.pop();
+            }
+            job();
+        }
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_THREADPOOL_H
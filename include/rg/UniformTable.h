@@ -0,0 +1,162 @@
+#ifndef PROJECT_BASE_UNIFORMTABLE_H
+#define PROJECT_BASE_UNIFORMTABLE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Per-frame counters for uniform location lookups. driverLookups counts calls that
+// reached glGetUniformLocation, tableLookups counts name lookups served from a cache.
+struct UniformLookupStats {
+    unsigned int driverLookups = 0;
+    unsigned int tableLookups = 0;
+};
+
+// Flat open-addressing hash table from uniform name to location, filled once
+// after linking by enumerating GL_ACTIVE_UNIFORMS of the program.
+class UniformTable {
+public:
+    static UniformLookupStats& frameStats()
+    {
+        static UniformLookupStats stats;
+        return stats;
+    }
+
+    static UniformLookupStats endFrame()
+    {
+        UniformLookupStats last = frameStats();
+        frameStats() = UniformLookupStats();
+        return last;
+    }
+
+    void build(GLuint program)
+    {
+        m_slots.clear();
+        m_count = 0;
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        // every array element gets its own entry, so reserve generously up front
+        m_slots.resize(nextPowerOfTwo(count * 4 + 16));
+
+        std::vector<GLchar> nameBuffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++) {
+            GLint size = 0;
+            GLenum type = 0;
+            GLsizei length = 0;
+            glGetActiveUniform(program, i, maxLength, &length, &size, &type, nameBuffer.data());
+            std::string name(nameBuffer.data(), length);
+
+            GLint location = glGetUniformLocation(program, name.c_str());
+            frameStats().driverLookups++;
+            if (location < 0)
+                continue; // uniform block members have no location
+            insert(name, location);
+
+            // arrays are reported as "name[0]"; register the bare name and the remaining elements too
+            std::size_t bracket = name.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == name.size()) {
+                std::string base = name.substr(0, bracket);
+                insert(base, location);
+                for (GLint element = 1; element < size; element++) {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    GLint elementLocation = glGetUniformLocation(program, elementName.c_str());
+                    frameStats().driverLookups++;
+                    if (elementLocation >= 0)
+                        insert(elementName, elementLocation);
+                }
+            }
+        }
+    }
+
+    // Returns -1 for names that are not active in the program, which glUniform* silently ignores.
+    GLint find(const char *name) const
+    {
+        frameStats().tableLookups++;
+        if (m_slots.empty())
+            return -1;
+        std::uint32_t hash = hashName(name);
+        std::size_t mask = m_slots.size() - 1;
+        for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const Slot &slot = m_slots[i];
+            if (slot.location == EMPTY)
+                return -1;
+            if (slot.hash == hash && slot.name == name)
+                return slot.location;
+        }
+    }
+
+    std::size_t size() const { return m_count; }
+
+private:
+    static constexpr GLint EMPTY = -2;
+
+    struct Slot {
+        std::uint32_t hash = 0;
+        GLint location = EMPTY;
+        std::string name;
+    };
+
+    std::vector<Slot> m_slots;
+    std::size_t m_count = 0;
+
+    static std::uint32_t hashName(const char *name)
+    {
+        // FNV-1a
+        std::uint32_t hash = 2166136261u;
+        for (; *name; ++name) {
+            hash ^= static_cast<unsigned char>(*name);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static std::size_t nextPowerOfTwo(std::size_t n)
+    {
+        std::size_t power = 1;
+        while (power < n)
+            power <<= 1;
+        return power;
+    }
+
+    void insert(const std::string &name, GLint location)
+    {
+        if ((m_count + 1) * 2 > m_slots.size())
+            grow();
+        std::uint32_t hash = hashName(name.c_str());
+        std::size_t mask = m_slots.size() - 1;
+        for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+            Slot &slot = m_slots[i];
+            if (slot.location == EMPTY) {
+                slot.hash = hash;
+                slot.location = location;
+                slot.name = name;
+                m_count++;
+                return;
+            }
+            if (slot.hash == hash && slot.name == name)
+                return;
+        }
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        m_slots.resize(old.size() * 2);
+        m_count = 0;
+        for (Slot &slot : old)
+            if (slot.location != EMPTY)
+                insert(slot.name, slot.location);
+    }
+};
+
+}
+
+#endif //PROJECT_BASE_UNIFORMTABLE_H
@@ -0,0 +1,106 @@
+#ifndef PROJECT_BASE_VERTEXPACKING_H
+#define PROJECT_BASE_VERTEXPACKING_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace rg {
+
+// Which vertex buffer layout a Mesh uploads. Packed meshes need shaders compiled with
+// PACKED_VERTEX, which decode the attributes below.
+enum class VertexFormat {
+    Float,  // Vertex as is, 56 bytes
+    Packed  // PackedVertex, 20 bytes
+};
+
+// 20 byte vertex:
+//
+//     location 0  position   4 x unorm16, xyz relative to the mesh AABB, w the tangent handedness
+//     location 1  normal     2 x snorm16, octahedral
+//     location 2  texCoords  2 x half float
+//     location 3  tangent    2 x snorm16, octahedral
+//
+// The bitangent isn't stored, shaders rebuild it as cross(N, T) * handedness. Positions
+// decode as positionOffset + aPackedPosition.xyz * positionScale, both set by Mesh::Draw.
+struct PackedVertex {
+    std::uint16_t position[4];
+    std::int16_t normal[2];
+    std::uint16_t texCoords[2];
+    std::int16_t tangent[2];
+};
+
+namespace packing {
+
+inline std::uint16_t unorm16(float value)
+{
+    return static_cast<std::uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline std::int16_t snorm16(float value)
+{
+    return static_cast<std::int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// IEEE binary16, rounded to nearest; too small values flush to zero, too large become infinity
+inline std::uint16_t half(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    std::uint32_t magnitude = bits & 0x7FFFFFFF;
+    if (magnitude >= 0x7F800000) // inf and nan
+        return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+    if (magnitude >= 0x477FF000) // rounds past the largest half
+        return sign | 0x7C00;
+    if (magnitude < 0x38800000) { // below the smallest normal half, store as denormal
+        if (magnitude < 0x33000000)
+            return sign;
+        std::uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+        int shift = 126 - static_cast<int>(magnitude >> 23);
+        return sign | static_cast<std::uint16_t>((mantissa + (1u << (shift - 1))) >> shift);
+    }
+    return sign | static_cast<std::uint16_t>((magnitude - 0x38000000 + 0xFFF + ((magnitude >> 13) & 1)) >> 13);
+}
+
+// unit vector onto the octahedron, unfolded into [-1, 1]^2
+inline glm::vec2 octahedral(const glm::vec3 &v)
+{
+    float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1 == 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec2 p(v.x / l1, v.y / l1);
+    if (v.z < 0.0f)
+        p = glm::vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+    return p;
+}
+
+// positionOffset and positionScale map unorm16 [0, 1] back onto the AABB
+inline PackedVertex pack(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &texCoords,
+                         const glm::vec3 &tangent, const glm::vec3 &bitangent,
+                         const glm::vec3 &positionOffset, const glm::vec3 &positionScale)
+{
+    PackedVertex packed;
+    for (int i = 0; i < 3; i++)
+        packed.position[i] = unorm16(positionScale[i] > 0.0f ? (position[i] - positionOffset[i]) / positionScale[i] : 0.0f);
+    // handedness of the tangent frame, 1 unless the UVs are mirrored
+    packed.position[3] = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? 0 : 65535;
+
+    glm::vec2 n = octahedral(normal), t = octahedral(tangent);
+    packed.normal[0] = snorm16(n.x);
+    packed.normal[1] = snorm16(n.y);
+    packed.tangent[0] = snorm16(t.x);
+    packed.tangent[1] = snorm16(t.y);
+    packed.texCoords[0] = half(texCoords.x);
+    packed.texCoords[1] = half(texCoords.y);
+    return packed;
+}
+
+}
+
+}
+
+#endif //PROJECT_BASE_VERTEXPACKING_H
@@ -5,8 +5,12 @@
  out vec2 TexCoords;
 
  uniform mat4 model;
- uniform mat4 view;
- uniform mat4 projection;
+
+ layout (std140) uniform FrameData {
+     mat4 projection;
+     mat4 view;
+     vec3 viewPos;
+ };
 
  void main()
  {
@@ -7,6 +7,7 @@ uniform sampler2D scene;
 uniform sampler2D bloomBlur;
 uniform bool bloom;
 uniform float exposure;
+uniform float bloomStrength = 1.0;
 
 void main()
 {
@@ -15,7 +16,7 @@ void main()
 
     vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
     if(bloom){
-        hdrColor += bloomColor; // additive blending
+        hdrColor += bloomColor * bloomStrength; // additive blending
         // tone mapping
         vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
         //vec3 result = hdrColor/(hdrColor + vec3(1.0));
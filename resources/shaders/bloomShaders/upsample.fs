@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+uniform float filterRadius = 1.0; // in texels of the smaller level
+
+// 3x3 tent filter, the result is added onto the larger level by blending
+void main()
+{
+    vec2 d = filterRadius / textureSize(image, 0);
+
+    vec3 result = texture(image, TexCoords).rgb * 4.0;
+    result += (texture(image, TexCoords + vec2(-d.x, 0.0)).rgb + texture(image, TexCoords + vec2(d.x, 0.0)).rgb
+             + texture(image, TexCoords + vec2(0.0, -d.y)).rgb + texture(image, TexCoords + vec2(0.0, d.y)).rgb) * 2.0;
+    result += texture(image, TexCoords + vec2(-d.x, -d.y)).rgb + texture(image, TexCoords + vec2(d.x, -d.y)).rgb
+            + texture(image, TexCoords + vec2(-d.x, d.y)).rgb + texture(image, TexCoords + vec2(d.x, d.y)).rgb;
+    FragColor = vec4(result / 16.0, 1.0);
+}
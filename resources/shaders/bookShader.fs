@@ -17,25 +17,26 @@ in SP_OUT {
 } sp_in;
 
 struct Material {
+#ifdef TEXTURE_ARRAYS
+    sampler2DArray texture_diffuse1;
+    sampler2DArray texture_specular1;
+    sampler2DArray texture_normal1;
+    sampler2DArray texture_height1;
+#else
     sampler2D texture_diffuse1;
     sampler2D texture_specular1;
     sampler2D texture_normal1;
     sampler2D texture_height1;
-
-    float shininess;
+#endif
 };
 
 struct DirLight {
-    vec3 direction;
-
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
 };
 
 struct PointLight {
-    vec3 position;
-
     float constant;
     float linear;
     float quadratic;
@@ -46,8 +47,6 @@ struct PointLight {
 };
 
 struct SpotLight {
-    vec3 position;
-    vec3 direction;
     float cutOff;
     float outerCutOff;
 
@@ -60,14 +59,30 @@ struct SpotLight {
     vec3 specular;
 };
 
-uniform bool flashLight;
+layout (std140) uniform LightData {
+    vec3 dirLightDirection;
+    vec3 pointLightPosition;
+    vec3 spotLightPosition;
+    vec3 spotLightDirection;
+    bool flashLight;
+};
 uniform float height_scale;
 uniform sampler2D depthMap;
 
 uniform Material material;
-uniform PointLight pointLight;
-uniform DirLight dirLight;
-uniform SpotLight spotLight;
+#ifdef TEXTURE_ARRAYS
+// layer of the model's texture arrays holding this mesh's material
+uniform int materialLayer;
+#define MATERIAL_TEXTURE(sampler, uv) texture(sampler, vec3(uv, materialLayer))
+#else
+#define MATERIAL_TEXTURE(sampler, uv) texture(sampler, uv)
+#endif
+layout (std140) uniform MaterialData {
+    DirLight dirLight;
+    PointLight pointLight;
+    SpotLight spotLight;
+    float shininess;
+};
 
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 color, vec2 texCoords);
@@ -85,10 +100,11 @@ void main()
         discard;
 
     // then sample textures with new texture coords
-    vec3 normal  = texture(material.texture_normal1, texCoords).rgb;
-    normal = normalize(normal * 2.0 - 1.0);
+    // baked normal maps are two channel BC5, z is rebuilt from x and y
+    vec2 normalXY = MATERIAL_TEXTURE(material.texture_normal1, texCoords).rg * 2.0 - 1.0;
+    vec3 normal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 
-    vec3 color = texture(material.texture_diffuse1, texCoords).rgb;
+    vec3 color = MATERIAL_TEXTURE(material.texture_diffuse1, texCoords).rgb;
 
     vec3 result = CalcDirLight(dirLight, normal, viewDir, color, texCoords);
     result += CalcPointLight(pointLight, normal, fs_in.TangentFragPos, viewDir, color, texCoords);
@@ -122,14 +138,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
 
     float diff = max(dot(lightDir, normal), 0.0);
     vec3 halfwayDir = normalize(lightDir + viewDir);
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
 
-    float distance    = length(light.position - fs_in.TangentFragPos);
+    float distance    = length(pointLightPosition - fs_in.TangentFragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
     vec3 ambient = light.ambient * color;
     vec3 diffuse = light.diffuse * diff * color;
-    vec3 specular = light.specular * spec * texture(material.texture_specular1, texCoords).rgb;
+    vec3 specular = light.specular * spec * MATERIAL_TEXTURE(material.texture_specular1, texCoords).rgb;
 
 
      ambient  *= attenuation;
@@ -147,11 +163,11 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 color, vec2 te
     float diff = max(dot(normal, lightDir), 0.0);
 
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
 
     vec3 ambient = light.ambient * color;
     vec3 diffuse = light.diffuse * diff * color;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, texCoords));
+    vec3 specular = light.specular * spec * vec3(MATERIAL_TEXTURE(material.texture_specular1, texCoords));
 
     return (ambient + diffuse + specular);
 
@@ -168,7 +184,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
     vec3 reflectDir = reflect(-lightDir, normal);
     vec3 halfwayDir = normalize(lightDir + viewDir);
 
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
 
 //     float distance = length(light.position - fragPos);
     float distance = length(sp_in.TangentSpotPos - fragPos);
@@ -180,7 +196,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
 
     vec3 ambient = light.ambient * color;
     vec3 diffuse = light.diffuse * diff * color;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, texCoords));
+    vec3 specular = light.specular * spec * vec3(MATERIAL_TEXTURE(material.texture_specular1, texCoords));
 
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
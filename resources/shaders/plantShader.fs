@@ -18,24 +18,24 @@ in SP_OUT {
 } sp_in;
 
 struct Material {
+#ifdef TEXTURE_ARRAYS
+    sampler2DArray texture_diffuse1;
+    sampler2DArray texture_specular1;
+    sampler2DArray texture_normal1;
+#else
     sampler2D texture_diffuse1;
     sampler2D texture_specular1;
     sampler2D texture_normal1;
-
-    float shininess;
+#endif
 };
 
 struct DirLight {
-    vec3 direction;
-
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
 };
 
 struct PointLight {
-    vec3 position;
-
     float constant;
     float linear;
     float quadratic;
@@ -46,8 +46,6 @@ struct PointLight {
 };
 
 struct SpotLight {
-    vec3 position;
-    vec3 direction;
     float cutOff;
     float outerCutOff;
 
@@ -61,13 +59,29 @@ struct SpotLight {
 };
 
 
-uniform bool flashLight;
+layout (std140) uniform LightData {
+    vec3 dirLightDirection;
+    vec3 pointLightPosition;
+    vec3 spotLightPosition;
+    vec3 spotLightDirection;
+    bool flashLight;
+};
 
 uniform Material material;
-
-uniform DirLight dirLight;
-uniform PointLight pointLight;
-uniform SpotLight spotLight;
+#ifdef TEXTURE_ARRAYS
+// layer of the model's texture arrays holding this mesh's material
+uniform int materialLayer;
+#define MATERIAL_TEXTURE(sampler, uv) texture(sampler, vec3(uv, materialLayer))
+#else
+#define MATERIAL_TEXTURE(sampler, uv) texture(sampler, uv)
+#endif
+
+layout (std140) uniform MaterialData {
+    DirLight dirLight;
+    PointLight pointLight;
+    SpotLight spotLight;
+    float shininess;
+};
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 color);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 color);
@@ -75,10 +89,12 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
 
 void main()
 {
-    vec3 normal = texture(material.texture_normal1, fs_in.TexCoords).rgb;
-    normal = normalize(normal * 2.0 - 1.0);  // this normal is in tangent space
+    // this normal is in tangent space; baked normal maps are two channel BC5, so z is
+    // rebuilt from x and y
+    vec2 normalXY = MATERIAL_TEXTURE(material.texture_normal1, fs_in.TexCoords).rg * 2.0 - 1.0;
+    vec3 normal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
     vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
-    vec3 color = texture(material.texture_diffuse1, fs_in.TexCoords).rgb;
+    vec3 color = MATERIAL_TEXTURE(material.texture_diffuse1, fs_in.TexCoords).rgb;
 
     vec3 result = CalcDirLight(dirLight, normal, viewDir, color);
     result += CalcPointLight(pointLight, normal, fs_in.TangentFragPos, viewDir, color);
@@ -105,11 +121,11 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 color)
     float diff = max(dot(normal, lightDir), 0.0);
 
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
 
     vec3 ambient = light.ambient * color;
     vec3 diffuse = light.diffuse * diff * color;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, fs_in.TexCoords));
+    vec3 specular = light.specular * spec * vec3(MATERIAL_TEXTURE(material.texture_specular1, fs_in.TexCoords));
 
     return (ambient + diffuse + specular);
 
@@ -122,14 +138,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
 
     float diff = max(dot(lightDir, normal), 0.0);
     vec3 halfwayDir = normalize(lightDir + viewDir);
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
 
-    float distance    = length(light.position - fs_in.TangentFragPos);
+    float distance    = length(pointLightPosition - fs_in.TangentFragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
     vec3 ambient = light.ambient * color;
     vec3 diffuse = light.diffuse * diff * color;
-    vec3 specular = light.specular * spec * texture(material.texture_specular1, fs_in.TexCoords).rgb;
+    vec3 specular = light.specular * spec * MATERIAL_TEXTURE(material.texture_specular1, fs_in.TexCoords).rgb;
 
 
      ambient  *= attenuation;
@@ -150,9 +166,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
     vec3 reflectDir = reflect(-lightDir, normal);
     vec3 halfwayDir = normalize(lightDir + viewDir);
 
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
 
-    float distance = length(light.position - fragPos);
+    float distance = length(spotLightPosition - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
     float theta = dot(lightDir, normalize(-sp_in.TangentSpotDir));
@@ -161,7 +177,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
 
     vec3 ambient = light.ambient * color;
     vec3 diffuse = light.diffuse * diff * color;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, fs_in.TexCoords));
+    vec3 specular = light.specular * spec * vec3(MATERIAL_TEXTURE(material.texture_specular1, fs_in.TexCoords));
 
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
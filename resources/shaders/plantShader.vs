@@ -1,9 +1,28 @@
 #version 330 core
+#ifdef PACKED_VERTEX
+// rg::PackedVertex, see include/rg/VertexPacking.h
+layout (location = 0) in vec4 aPackedPosition; // xyz in the mesh AABB, w handedness
+layout (location = 1) in vec2 aPackedNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec2 aPackedTangent;
+
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+#endif
 
 out VS_OUT {
      vec3 FragPos;
@@ -20,19 +39,29 @@ out SP_OUT {
     vec3 TangentSpotDir;
 } sp_out;
 
-uniform mat4 projection;
-uniform mat4 view;
 uniform mat4 model;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 lightDir;
+layout (std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
-uniform vec3 spotPosition;
-uniform vec3 spotDirection;
+layout (std140) uniform LightData {
+    vec3 dirLightDirection;
+    vec3 pointLightPosition;
+    vec3 spotLightPosition;
+    vec3 spotLightDirection;
+    bool flashLight;
+};
 
 void main()
 {
+#ifdef PACKED_VERTEX
+    vec3 aPos     = positionOffset + aPackedPosition.xyz * positionScale;
+    vec3 aNormal  = octahedralDecode(aPackedNormal);
+    vec3 aTangent = octahedralDecode(aPackedTangent);
+#endif
     vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
     vs_out.TexCoords = aTexCoords;
 
@@ -44,13 +73,13 @@ void main()
     vec3 B = cross(N, T);
 
     mat3 TBN = transpose(mat3(T, B, N));
-    vs_out.TangentLightPos = TBN * lightPos;
+    vs_out.TangentLightPos = TBN * pointLightPosition;
     vs_out.TangentViewPos  = TBN * viewPos;
     vs_out.TangentFragPos  = TBN * vs_out.FragPos;
-    vs_out.TangentLightDir = TBN * lightDir;
+    vs_out.TangentLightDir = TBN * dirLightDirection;
 
-    sp_out.TangentSpotPos    = TBN * spotPosition;
-    sp_out.TangentSpotDir    = TBN * spotDirection;
+    sp_out.TangentSpotPos    = TBN * spotLightPosition;
+    sp_out.TangentSpotDir    = TBN * spotLightDirection;
 
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
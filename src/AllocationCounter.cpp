@@ -0,0 +1,26 @@
+#include <rg/AllocationCounter.h>
+
+#include <cstdlib>
+#include <new>
+
+// Replacements of the global operator new and delete, feeding rg::AllocationCounter. They
+// have to live in exactly one translation unit of the program, hence this file.
+
+// the array and nothrow forms of new and delete end up in these
+void* operator new(std::size_t size)
+{
+    rg::AllocationCounter::count(size);
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -10,7 +10,30 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
+#include <imgui.h>
+#include <imgui_impl_glfw.h>
+#include <imgui_impl_opengl3.h>
+
 #include <rg/Texture2D.h>
+#include <rg/TextureCache.h>
+#include <rg/FrameUniforms.h>
+#include <rg/Material.h>
+#include <rg/ProgramRegistry.h>
+#include <rg/InstanceBuffer.h>
+#include <rg/Scene.h>
+#include <rg/Frustum.h>
+#include <rg/Lod.h>
+#include <rg/RenderTargetPool.h>
+#include <rg/BloomPyramid.h>
+#include <rg/DynamicResolution.h>
+#include <rg/Profiler.h>
+#include <rg/GaussianKernel.h>
+#include <rg/GLCallCounter.h>
+#include <rg/RenderState.h>
+#include <rg/Benchmark.h>
+#include <rg/FrameCapture.h>
+#include <rg/RegressionCapture.h>
+#include <rg/AllocationCounter.h>
 
 #include <iostream>
 
@@ -25,6 +48,9 @@ unsigned int loadTexture(char const * path);
 // settings
 const unsigned int SCR_WIDTH = 1080;
 const unsigned int SCR_HEIGHT = 720;
+// size of the default framebuffer, kept up to date by framebuffer_size_callback
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
 bool flashLight = false;
 bool flashLightKeyPressed = false;
 bool bloomKeyPressed = false;
@@ -37,6 +63,38 @@ bool cursorToggle = false;
 bool AABloom = true;
 bool AABloomKeyPressed = false;
 
+// bloomPyramid = true blurs through the downsampled mip chain
+// bloomPyramid = false uses the full resolution ping-pong Gaussian blur
+bool bloomPyramid = true;
+bool bloomPyramidKeyPressed = false;
+const unsigned int BLOOM_LEVELS = 6;
+
+// radius in texels of the ping-pong Gaussian blur, changed with [ and ]
+int blurRadius = 8;
+bool blurRadiusChanged = true;
+bool blurRadiusKeyPressed = false;
+
+// dynamic resolution lowers the internal render scale when the GPU time of a frame
+// goes over the budget, toggled with R
+bool dynamicResolution = true;
+bool dynamicResolutionKeyPressed = false;
+const float GPU_FRAME_BUDGET_MS = 16.0f;
+float lastGpuMilliseconds = 0.0f;
+float lastRenderScale = 1.0f;
+
+// per-pass timings, shown with T and written to profile.csv with O
+bool showProfiler = false;
+bool showProfilerKeyPressed = false;
+bool dumpProfile = false;
+
+// uniform location lookups made during the last rendered frame, printed with L
+rg::UniformLookupStats lastFrameLookups;
+rg::CullStats lastFrameCulling;
+rg::LodStats lastFrameLods;
+rg::GLCallStats lastFrameCalls;
+rg::RenderStateStats lastFrameState;
+rg::AllocationStats lastFrameAllocations;
+
 // camera
 //Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 //Camera camera(glm::vec3(8.0f, 3.0f, 10.0f));
@@ -55,13 +113,22 @@ glm::vec3 lightPos = glm::vec3(0.0f, 10.0f, 0.0f);
 glm::vec3 dirPos = glm::vec3(60, 20, 60);
 float heightScale = 0.1;
 
-int main() {
+int main(int argc, char **argv) {
+    // --bench replays a fixed camera path in a hidden window and writes a JSON report
+    const rg::Benchmark::Options benchOptions = rg::Benchmark::parse(argc, argv);
+    rg::Benchmark bench(benchOptions);
+    // --capture renders fixed shots through every render path and compares them with --golden
+    const rg::RegressionCapture::Options captureOptions = rg::RegressionCapture::parse(argc, argv);
+    const bool scripted = benchOptions.enabled || captureOptions.enabled;
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (scripted)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // glfw window creation
     // --------------------
@@ -73,6 +140,7 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
@@ -86,829 +154,526 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    rg::GLCallCounter::install();
+    rg::RenderState::install();
+
+    if (scripted) {
+        // measure the frames, not the vsync interval, and keep the resolution fixed
+        glfwSwapInterval(0);
+        dynamicResolution = false;
+    }
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
     glEnable(GL_CULL_FACE);
 
-    Shader floorShader("resources/shaders/uniformLightShader.vs", "resources/shaders/uniformLightShader.fs");
-    Shader pyramidShader("resources/shaders/uniformLightShader.vs", "resources/shaders/uniformLightShader.fs");
-    Shader objectShader("resources/shaders/uniformLightShader.vs", "resources/shaders/uniformLightShader.fs");
-    Shader tableTopCubeShader("resources/shaders/uniformLightShader.vs", "resources/shaders/uniformLightShader.fs");
-    Shader blendingShader("resources/shaders/blendingShader.vs", "resources/shaders/blendingShader.fs");
-
-    Shader skyboxShader("resources/shaders/skyboxShader.vs", "resources/shaders/skyboxShader.fs");
-    Shader lightCubeShader("resources/shaders/uniformLightShader.vs", "resources/shaders/lightcube.fs");
-
-    Shader shaderBlur("resources/shaders/bloomShaders/blur.vs", "resources/shaders/bloomShaders/blur.fs");
-    Shader shaderBloomFinal("resources/shaders/bloomShaders/bloom.vs", "resources/shaders/bloomShaders/bloom.fs");
-
-
-    Shader plantShader("resources/shaders/plantShader.vs", "resources/shaders/plantShader.fs");
-    Model plant(FileSystem::getPath("resources/objects/azalea/Azalea_SF.obj"), true);
-    plant.SetShaderTextureNamePrefix("material.");
-
-    Shader bookShader("resources/shaders/bookShader.vs", "resources/shaders/bookShader.fs");
-    Model book(FileSystem::getPath("resources/objects/hobbit-book/hobbit_book_SF.obj"), true);
-    book.SetShaderTextureNamePrefix("material.");
-
-    Model sphere(FileSystem::getPath("resources/objects/xxr-sphere/XXR_B_BLOODSTONE_002.obj"), true);
-    sphere.SetShaderTextureNamePrefix("material.");
-
-    // Sejder za framebuffer - crta pravougaonik preko celog ekrana na koji ce
-    // biti nalepljena renderovana slika scene (nakon postprocesiranja).
-    Shader screenShader("resources/shaders/screenShader.vs", "resources/shaders/screenShader.fs");
-
-    // configure MSAA framebuffer
-    // --------------------------
-    unsigned int framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    // create a multisampled color attachment texture
-    unsigned int textureColorBufferMultiSampled;
-    glGenTextures(1, &textureColorBufferMultiSampled);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled);
-    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, SCR_WIDTH, SCR_HEIGHT, GL_TRUE);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled, 0);
-    // create a (also multisampled) renderbuffer object for depth and stencil attachments
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // configure second post-processing framebuffer
-    unsigned int intermediateFBO;
-    glGenFramebuffers(1, &intermediateFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
-    // create a color attachment texture
-    unsigned int screenTexture;
-    glGenTextures(1, &screenTexture);
-    glBindTexture(GL_TEXTURE_2D, screenTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenTexture, 0);	// we only need a color buffer
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        cout << "ERROR::FRAMEBUFFER:: Intermediate framebuffer is not complete!" << endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    //Bloom-------------------------------------------------------------------------------------------------------------
-    // configure framebuffers
-    // ---------------------------------------
-    unsigned int hdrFBO;
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    // create 2 color buffers (1 for normal rendering, other for brightness threshold values)
-    unsigned int colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffers[0], 0); //<=
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);//<=
-    // check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // ping-pong-framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-    }
+    // imgui, used for the profiler overlay; it chains the callbacks installed above
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
 
-    floorShader.use();
-    floorShader.setInt("diffuseTexture", 0);
-    tableTopCubeShader.use();
-    tableTopCubeShader.setInt("diffuseTexture", 0);
-    pyramidShader.use();
-    pyramidShader.setInt("diffuseTexture", 0);
-    shaderBlur.use();
-    shaderBlur.setInt("image", 0);
-    shaderBloomFinal.use();
-    shaderBloomFinal.setInt("scene", 0);
-    shaderBloomFinal.setInt("bloomBlur", 1);
-
-    // cube vertices
-
-    float vertices[] = {
-            // back face
-            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-            1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
-            1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-            // front face
-            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-            1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-            1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-            1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-            // left face
-            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
-            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-            // right face
-            1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-            1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-            1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-            1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-            1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-            1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // bottom face
-            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-            1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
-            1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-            1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-            // top face
-            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-            1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
-            1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
-    };
-
-    unsigned int cubeVAO, cubeVBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindVertexArray(cubeVAO);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    float quadVertices[] = {   // vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
-            // positions   // texCoords
-            -1.0f,  1.0f,  0.0f, 1.0f,
-            -1.0f, -1.0f,  0.0f, 0.0f,
-            1.0f, -1.0f,  1.0f, 0.0f,
-
-            -1.0f,  1.0f,  0.0f, 1.0f,
-            1.0f, -1.0f,  1.0f, 0.0f,
-            1.0f,  1.0f,  1.0f, 1.0f
-    };
-    // setup screen VAO
-    unsigned int quadVAO, quadVBO;
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-
-    // pyramid coordinates
-    float pyramidVertices[] = {
-            // positions         // normals           // texture coords
-            1.0f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,    //A
-            0.0f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,  5.0f,  0.0f,    //B
-            -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,    //C
-            0.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  5.0f,  0.0f,    //D
-            0.0f,  0.0f,  2.0f,  0.0f,  0.0f,  1.0f,  2.5f,  5.0f,	   //E
-    };
-
-    unsigned int pyramidIndices[] = {
-            0, 3, 1,
-            1, 3, 2,
-            0, 1, 4,
-            0, 4, 3,
-            2, 3, 4,
-            1, 2, 4
-    };
-
-    unsigned int pyramidVAO, pyramidVBO, pyramidEBO;
-    glGenVertexArrays(1, &pyramidVAO);
-    glGenBuffers(1, &pyramidVBO);
-    glGenBuffers(1, &pyramidEBO);
-
-    glBindVertexArray(pyramidVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, pyramidVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(pyramidVertices), pyramidVertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pyramidEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(pyramidIndices), pyramidIndices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    Texture2D woodTexture("resources/textures/table.jpg", 0);
-    Texture2D pyramidTexture("resources/textures/bricks2.jpg", 1);
-
-    floorShader.use();
-    floorShader.setInt("material.specular", woodTexture.getTextureNumber());
-
-    pyramidShader.use();
-    pyramidShader.setInt("material.diffuse", pyramidTexture.getTextureNumber());
-
-    // tabletop cube definitions and light
-
-    unsigned int tableTopCubeVBO, tableTopCubeVAO;
-    glGenVertexArrays(1, &tableTopCubeVAO);
-    glGenBuffers(1, &tableTopCubeVBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, tableTopCubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(tableTopCubeVAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    Texture2D tableTopCubeTexture("resources/textures/red_brick3.jpg", 2);
-
-    tableTopCubeShader.use();
-    tableTopCubeShader.setInt("material.diffuse", tableTopCubeTexture.getTextureNumber());
-
-    // transparent vertices
-
-    float transparentVertices[] = {
-            // positions         // texture Coords (swapped y coordinates because texture is flipped upside down)
-            0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
-            1.0f, -0.5f,  0.0f,  1.0f,  1.0f,
-            0.0f, -0.5f,  0.0f,  0.0f,  1.0f,
-
-            0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
-            1.0f,  0.5f,  0.0f,  1.0f,  1.0f,
-            1.0f, -0.5f,  0.0f,  1.0f,  0.0f
-    };
-
-    unsigned int transparentVAO, transparentVBO;
-    glGenVertexArrays(1, &transparentVAO);
-    glGenBuffers(1, &transparentVBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, transparentVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(transparentVertices), transparentVertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(transparentVAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    Texture2D transparentTexture("resources/textures/crack.png", 3);
-
-    blendingShader.use();
-    blendingShader.setInt("texture1", transparentTexture.getTextureNumber());
-
-    // light source cube
-
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    // note that we update the lamp's position attribute's stride to reflect the updated buffer data
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // skybox setup
-
-    float skyboxVertices[] = {
-            // positions
-            -1.0f,  1.0f, -1.0f,
-            -1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            -1.0f,  1.0f, -1.0f,
-            1.0f,  1.0f, -1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-            1.0f, -1.0f,  1.0f
-    };
-
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-
-    vector<std::string> skyboxSides = {
-            FileSystem::getPath("resources/textures/skyboxTextures/right.jpg"), // 0
-            FileSystem::getPath("resources/textures/skyboxTextures/left.jpg"),  // 1
-            FileSystem::getPath("resources/textures/skyboxTextures/top.jpg"),  // 2
-            FileSystem::getPath("resources/textures/skyboxTextures/bottom.jpg"),  // 3
-            FileSystem::getPath("resources/textures/skyboxTextures/front.jpg"),  // 4
-            FileSystem::getPath("resources/textures/skyboxTextures/back.jpg") // 5
-    };
-
-    Texture2D skyboxTexture(skyboxSides, 4);
-
-    skyboxShader.use();
-    skyboxShader.setInt("skybox", skyboxTexture.getTextureNumber());
-
-    screenShader.use();
-    screenShader.setInt("screenTexture", 0);
-
-    // TODO: Da li moze preko klase Texture2D
-    unsigned int heightMap = loadTexture("resources/objects/hobbit-book/hobbit_book_retopo_height.jpg");
-
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // spinning cube
-        // the following two lines are commented out, but can be uncommented
-        // if you wish to see how the constant changing of the light position
-        // affects the lighting on objects
-
-//        lightPos.x = 5*sin(currentFrame)+1;
-//        lightPos.z = 5*cos(currentFrame)+1;
-
-        processInput(window);
-
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // render scene into floating point framebuffer
-        // -----------------------------------------------BLOOM
-
-        if(AABloom){
-            glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glEnable(GL_DEPTH_TEST);
-        }else{
-            // 1. draw scene as normal in multisampled buffers
-            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glEnable(GL_DEPTH_TEST);
-        }
+    // Everything owning GL objects lives in this block, so it is destroyed while the
+    // context is still current.
+    bool capturesMatch = true;
+    {
+        // every program is compiled and linked once, no matter how many objects use it
+        rg::ProgramRegistry programs;
+
+        // floor, table edges, pyramids, table top cubes and the sphere, all drawn instanced
+        Shader &litShader = programs.get("resources/shaders/uniformLightShader.vs", "resources/shaders/uniformLightShader.fs",
+                                         "#define INSTANCED");
+        Shader &blendingShader = programs.get("resources/shaders/blendingShader.vs", "resources/shaders/blendingShader.fs");
+
+        Shader &skyboxShader = programs.get("resources/shaders/skyboxShader.vs", "resources/shaders/skyboxShader.fs");
+        Shader &lightCubeShader = programs.get("resources/shaders/uniformLightShader.vs", "resources/shaders/lightcube.fs");
+
+        Shader &shaderBlur = programs.get("resources/shaders/bloomShaders/blur.vs", "resources/shaders/bloomShaders/blur.fs");
+        Shader &shaderBloomFinal = programs.get("resources/shaders/bloomShaders/bloom.vs", "resources/shaders/bloomShaders/bloom.fs");
+        Shader &shaderBloomDownsample = programs.get("resources/shaders/bloomShaders/sample.vs", "resources/shaders/bloomShaders/downsample.fs");
+        Shader &shaderBloomUpsample = programs.get("resources/shaders/bloomShaders/sample.vs", "resources/shaders/bloomShaders/upsample.fs");
+
+
+        // Plant and book upload rg::PackedVertex, their shaders decode it. Their materials are
+        // moved into texture arrays where the images allow it, the shaders follow suit.
+        Model plant(FileSystem::getPath("resources/objects/azalea/Azalea_SF.obj"), true, rg::VertexFormat::Packed);
+        plant.SetShaderTextureNamePrefix("material.");
+        Shader &plantShader = programs.get("resources/shaders/plantShader.vs", "resources/shaders/plantShader.fs",
+                                           plant.useTextureArrays() ? "#define PACKED_VERTEX\n#define TEXTURE_ARRAYS" : "#define PACKED_VERTEX");
+
+        Model book(FileSystem::getPath("resources/objects/hobbit-book/hobbit_book_SF.obj"), true, rg::VertexFormat::Packed);
+        book.SetShaderTextureNamePrefix("material.");
+        Shader &bookShader = programs.get("resources/shaders/bookShader.vs", "resources/shaders/bookShader.fs",
+                                          book.useTextureArrays() ? "#define INSTANCED\n#define PACKED_VERTEX\n#define TEXTURE_ARRAYS"
+                                                                  : "#define INSTANCED\n#define PACKED_VERTEX");
+
+        Model sphere(FileSystem::getPath("resources/objects/xxr-sphere/XXR_B_BLOODSTONE_002.obj"), true);
+        sphere.SetShaderTextureNamePrefix("material.");
+
+        // Sejder za framebuffer - crta pravougaonik preko celog ekrana na koji ce
+        // biti nalepljena renderovana slika scene (nakon postprocesiranja).
+        Shader &screenShader = programs.get("resources/shaders/screenShader.vs", "resources/shaders/screenShader.fs");
+
+        // camera and light placement are shared by all scene shaders through uniform buffers
+        rg::FrameUniforms frameUniforms;
+
+        // The MSAA, HDR and blur targets are taken from the pool every frame, at the current
+        // framebuffer size times the render scale. Targets of the same format are shared
+        // between passes that don't overlap.
+        // ---------------------------------------
+        rg::RenderTargetPool renderTargets;
+        const rg::TargetFormat hdrFormat = rg::TargetFormat::texture(GL_RGBA16F);
+        rg::DynamicResolution resolutionController(GPU_FRAME_BUDGET_MS);
+        rg::Profiler profiler(benchOptions.enabled ? benchOptions.frames : 240);
+
+        // mip-chain alternative to the ping-pong blur
+        rg::BloomPyramid bloomMips(BLOOM_LEVELS, shaderBloomDownsample, shaderBloomUpsample);
+
+        litShader.use();
+        litShader.setInt("diffuseTexture", 0);
+        shaderBlur.use();
+        shaderBlur.setInt("image", 0);
+        shaderBloomFinal.use();
+        shaderBloomFinal.setInt("scene", 0);
+        shaderBloomFinal.setInt("bloomBlur", 1);
+        // the parallax height map sits on the unit after the material textures; left at 0 it
+        // would share a unit with the diffuse texture array
+        bookShader.use();
+        bookShader.setInt("depthMap", book.meshes[0].textures.size());
+
+        // locations of the per-draw model matrices, looked up once instead of on every draw
+        const GLint blendingShaderModelLoc = blendingShader.uniformLocation("model");
+        const GLint plantShaderModelLoc = plantShader.uniformLocation("model");
+        const GLint lightCubeShaderModelLoc = lightCubeShader.uniformLocation("model");
+
+        // cube vertices
+
+        float vertices[] = {
+                // back face
+                -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+                1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+                1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+                1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+                -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+                -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+                // front face
+                -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+                1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+                1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+                1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+                -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+                -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+                // left face
+                -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+                -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+                -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+                -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+                -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+                -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+                // right face
+                1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+                1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+                1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+                1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+                1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+                1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // bottom face
+                -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+                1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+                1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+                1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+                -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+                -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+                // top face
+                -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+                1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+                1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+                1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+                -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+                -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
+        };
 
-        woodTexture.bind();
-        pyramidTexture.bind();
-        tableTopCubeTexture.bind();
-        transparentTexture.bind();
-        skyboxTexture.bindCubemap();
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 model = glm::mat4(1.0f);
-
-        // Floor setup.
-        floorShader.use();
-        floorShader.setVec3("viewPos", lightPos);
-        floorShader.setFloat("material.shininess", 7.0f);
-        floorShader.setInt("flashLight", flashLight);
-
-        // light properties
-
-        floorShader.setVec3("dirLight.direction", glm::vec3(dirPos));
-        floorShader.setVec3("dirLight.ambient", 0.1f, 0.1f, 0.1f);
-        floorShader.setVec3("dirLight.diffuse", 0.55f, 0.55f, 0.55f);
-        floorShader.setVec3("dirLight.specular", 0.0f, 0.0f, 0.0f);
-
-        floorShader.setVec3("pointLight.position", lightPos);
-        floorShader.setVec3("pointLight.ambient", 0.1f, 0.1f, 0.1f);
-        floorShader.setVec3("pointLight.diffuse", 0.95f, 0.95f, 0.95f);
-        floorShader.setVec3("pointLight.specular", 0.5f, 0.5f, 0.5f);
-        floorShader.setFloat("pointLight.constant", 1.0f);
-        floorShader.setFloat("pointLight.linear", 0.22f);
-        floorShader.setFloat("pointLight.quadratic", 0.0009f);
-
-        floorShader.setVec3("spotLight.position", camera.Position);
-        floorShader.setVec3("spotLight.direction", camera.Front);
-        floorShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        floorShader.setVec3("spotLight.diffuse", 0.5f, 0.5f, 0.5f);
-        floorShader.setVec3("spotLight.specular", 0.03f, 0.03f, 0.03f);
-        floorShader.setFloat("spotLight.constant", 1.0f);
-        floorShader.setFloat("spotLight.linear", 0.007f);
-        floorShader.setFloat("spotLight.quadratic", 0.0002f);
-        floorShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(7.5f)));
-        floorShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(13.0f)));
-
-        floorShader.setMat4("projection", projection);
-        floorShader.setMat4("view", view);
-        model = glm::scale(model, glm::vec3(12.5f, 0.1f, 12.5f));
-        floorShader.setMat4("model", model);
+        unsigned int cubeVAO, cubeVBO;
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
 
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
 
-        // Edges of the table.
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        float quadVertices[] = {   // vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
+                // positions   // texCoords
+                -1.0f,  1.0f,  0.0f, 1.0f,
+                -1.0f, -1.0f,  0.0f, 0.0f,
+                1.0f, -1.0f,  1.0f, 0.0f,
+
+                -1.0f,  1.0f,  0.0f, 1.0f,
+                1.0f, -1.0f,  1.0f, 0.0f,
+                1.0f,  1.0f,  1.0f, 1.0f
+        };
+        // setup screen VAO
+        unsigned int quadVAO, quadVBO;
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+        // pyramid coordinates
+        float pyramidVertices[] = {
+                // positions         // normals           // texture coords
+                1.0f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,    //A
+                0.0f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,  5.0f,  0.0f,    //B
+                -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,    //C
+                0.0f, -1.0f,  0.0f,  0.0f, -1.0f,  0.0f,  5.0f,  0.0f,    //D
+                0.0f,  0.0f,  2.0f,  0.0f,  0.0f,  1.0f,  2.5f,  5.0f,	   //E
+        };
+
+        unsigned int pyramidIndices[] = {
+                0, 3, 1,
+                1, 3, 2,
+                0, 1, 4,
+                0, 4, 3,
+                2, 3, 4,
+                1, 2, 4
+        };
+
+        unsigned int pyramidVAO, pyramidVBO, pyramidEBO;
+        glGenVertexArrays(1, &pyramidVAO);
+        glGenBuffers(1, &pyramidVBO);
+        glGenBuffers(1, &pyramidEBO);
+
+        glBindVertexArray(pyramidVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, pyramidVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(pyramidVertices), pyramidVertices, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pyramidEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(pyramidIndices), pyramidIndices, GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        Texture2D woodTexture("resources/textures/table.jpg", 0);
+        Texture2D pyramidTexture("resources/textures/bricks2.jpg", 1);
+
+        // tabletop cube definitions and light
+
+        unsigned int tableTopCubeVBO, tableTopCubeVAO;
+        glGenVertexArrays(1, &tableTopCubeVAO);
+        glGenBuffers(1, &tableTopCubeVBO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, tableTopCubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        glBindVertexArray(tableTopCubeVAO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        Texture2D tableTopCubeTexture("resources/textures/red_brick3.jpg", 2);
+
+        // transparent vertices
+
+        float transparentVertices[] = {
+                // positions         // texture Coords (swapped y coordinates because texture is flipped upside down)
+                0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
+                1.0f, -0.5f,  0.0f,  1.0f,  1.0f,
+                0.0f, -0.5f,  0.0f,  0.0f,  1.0f,
+
+                0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
+                1.0f,  0.5f,  0.0f,  1.0f,  1.0f,
+                1.0f, -0.5f,  0.0f,  1.0f,  0.0f
+        };
+
+        unsigned int transparentVAO, transparentVBO;
+        glGenVertexArrays(1, &transparentVAO);
+        glGenBuffers(1, &transparentVBO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, transparentVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(transparentVertices), transparentVertices, GL_STATIC_DRAW);
+
+        glBindVertexArray(transparentVAO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        Texture2D transparentTexture("resources/textures/crack.png", 3);
+
+        blendingShader.use();
+        blendingShader.setInt("texture1", transparentTexture.getTextureNumber());
+
+        // light source cube
+
+        unsigned int lightCubeVAO;
+        glGenVertexArrays(1, &lightCubeVAO);
+        glBindVertexArray(lightCubeVAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        // note that we update the lamp's position attribute's stride to reflect the updated buffer data
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // skybox setup
+
+        float skyboxVertices[] = {
+                // positions
+                -1.0f,  1.0f, -1.0f,
+                -1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+                1.0f,  1.0f, -1.0f,
+                -1.0f,  1.0f, -1.0f,
+
+                -1.0f, -1.0f,  1.0f,
+                -1.0f, -1.0f, -1.0f,
+                -1.0f,  1.0f, -1.0f,
+                -1.0f,  1.0f, -1.0f,
+                -1.0f,  1.0f,  1.0f,
+                -1.0f, -1.0f,  1.0f,
+
+                1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+
+                -1.0f, -1.0f,  1.0f,
+                -1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f, -1.0f,  1.0f,
+                -1.0f, -1.0f,  1.0f,
+
+                -1.0f,  1.0f, -1.0f,
+                1.0f,  1.0f, -1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                -1.0f,  1.0f,  1.0f,
+                -1.0f,  1.0f, -1.0f,
+
+                -1.0f, -1.0f, -1.0f,
+                -1.0f, -1.0f,  1.0f,
+                1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+                -1.0f, -1.0f,  1.0f,
+                1.0f, -1.0f,  1.0f
+        };
+
+        unsigned int skyboxVAO, skyboxVBO;
+        glGenVertexArrays(1, &skyboxVAO);
+        glGenBuffers(1, &skyboxVBO);
+        glBindVertexArray(skyboxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+        vector<std::string> skyboxSides = {
+                FileSystem::getPath("resources/textures/skyboxTextures/right.jpg"), // 0
+                FileSystem::getPath("resources/textures/skyboxTextures/left.jpg"),  // 1
+                FileSystem::getPath("resources/textures/skyboxTextures/top.jpg"),  // 2
+                FileSystem::getPath("resources/textures/skyboxTextures/bottom.jpg"),  // 3
+                FileSystem::getPath("resources/textures/skyboxTextures/front.jpg"),  // 4
+                FileSystem::getPath("resources/textures/skyboxTextures/back.jpg") // 5
+        };
+
+        Texture2D skyboxTexture(skyboxSides, 4);
+
+        skyboxShader.use();
+        skyboxShader.setInt("skybox", skyboxTexture.getTextureNumber());
+
+        screenShader.use();
+        screenShader.setInt("screenTexture", 0);
+
+        // TODO: Da li moze preko klase Texture2D
+        unsigned int heightMap = loadTexture("resources/objects/hobbit-book/hobbit_book_retopo_height.jpg");
+
+        // Objects drawn with litShader differ only in their materials: how strongly they respond
+        // to each light and which texture units their samplers read. Plant and book get one too.
+        // --------------------------------------------------------------------------
+        rg::MaterialBuffer materials;
+        rg::MaterialData materialData;
+
+        rg::Material floorMaterial;
+        materialData.shininess = 7.0f;
+        materialData.dirLight = rg::DirLightData(glm::vec3(0.1f), glm::vec3(0.55f), glm::vec3(0.0f));
+        materialData.pointLight = rg::PointLightData(glm::vec3(0.1f), glm::vec3(0.95f), glm::vec3(0.5f), 1.0f, 0.22f, 0.0009f);
+        materialData.spotLight = rg::SpotLightData(glm::vec3(0.0f), glm::vec3(0.5f), glm::vec3(0.03f), 1.0f, 0.007f, 0.0002f,
+                                                   glm::cos(glm::radians(7.5f)), glm::cos(glm::radians(13.0f)));
+        floorMaterial.block = materials.add(materialData);
+        floorMaterial.diffuseUnit = woodTexture.getTextureNumber();
+        floorMaterial.specularUnit = woodTexture.getTextureNumber();
+
+        rg::Material pyramidMaterial;
+        materialData.shininess = 1.0f;
+        materialData.dirLight = rg::DirLightData(glm::vec3(0.1f), glm::vec3(0.2f), glm::vec3(0.0f));
+        materialData.pointLight = rg::PointLightData(glm::vec3(0.1f, 0.1f, 0.05f), glm::vec3(0.4f), glm::vec3(0.6f), 1.0f, 0.07f, 0.00002f);
+        materialData.spotLight = rg::SpotLightData(glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.8f), 1.0f, 0.007f, 0.0002f,
+                                                   glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)));
+        pyramidMaterial.block = materials.add(materialData);
+        pyramidMaterial.diffuseUnit = pyramidTexture.getTextureNumber();
+        pyramidMaterial.specularUnit = woodTexture.getTextureNumber();
+
+        // directional light comes from the window of the skybox
+        // which is approximately (somewhere) behind the cubes, and is not as bright
+        rg::Material tableTopCubeMaterial;
+        materialData.shininess = 32.0f;
+        materialData.dirLight = rg::DirLightData(glm::vec3(0.1f), glm::vec3(0.55f), glm::vec3(0.0f));
+        materialData.pointLight = rg::PointLightData(glm::vec3(0.05f), glm::vec3(1.0f), glm::vec3(0.3f), 1.0f, 0.007f, 0.0002f);
+        materialData.spotLight = rg::SpotLightData(glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.3f), 1.0f, 0.007f, 0.0002f,
+                                                   glm::cos(glm::radians(9.0f)), glm::cos(glm::radians(12.0f)));
+        tableTopCubeMaterial.block = materials.add(materialData);
+        tableTopCubeMaterial.diffuseUnit = tableTopCubeTexture.getTextureNumber();
+        tableTopCubeMaterial.specularUnit = woodTexture.getTextureNumber();
+
+        // the sphere's own textures are bound to the first units by Mesh::Draw
+        rg::Material sphereMaterial;
+        materialData.shininess = 18.0f;
+        materialData.dirLight = rg::DirLightData(glm::vec3(0.1f), glm::vec3(0.2f), glm::vec3(0.0f));
+        materialData.pointLight = rg::PointLightData(glm::vec3(0.05f), glm::vec3(1.0f), glm::vec3(0.0f), 1.0f, 0.007f, 0.0002f);
+        materialData.spotLight = rg::SpotLightData(glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(1.2f), 1.0f, 0.007f, 0.0002f,
+                                                   glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)));
+        sphereMaterial.block = materials.add(materialData);
+
+        rg::Material plantMaterial;
+        materialData.shininess = 18.0f;
+        materialData.dirLight = rg::DirLightData(glm::vec3(0.1f), glm::vec3(0.2f), glm::vec3(0.1f));
+        materialData.pointLight = rg::PointLightData(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(0.0f), 1.0f, 0.007f, 0.0002f);
+        materialData.spotLight = rg::SpotLightData(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(1.2f), 1.0f, 0.007f, 0.0002f,
+                                                   glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)));
+        plantMaterial.block = materials.add(materialData);
+
+        rg::Material bookMaterial;
+        materialData.shininess = 32.0f;
+        materialData.dirLight = rg::DirLightData(glm::vec3(0.1f), glm::vec3(0.2f), glm::vec3(0.1f));
+        materialData.pointLight = rg::PointLightData(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(0.1f), 1.0f, 0.007f, 0.0002f);
+        materialData.spotLight = rg::SpotLightData(glm::vec3(0.1f), glm::vec3(1.0f), glm::vec3(1.2f), 1.0f, 0.007f, 0.0002f,
+                                                   glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)));
+        bookMaterial.block = materials.add(materialData);
+
+        materials.upload();
+
+        const rg::MaterialSamplers litSamplers(litShader);
+
+        // Scene graph: every object is a node, each batch is one draw call (instanced where
+        // the program supports it). World matrices are only recomputed when a node moves.
+        // --------------------------------------------------------------------------
+        const rg::Bounds cubeBounds = rg::Bounds::fromPositions(vertices, 36, 8);
+        const rg::Bounds pyramidBounds = rg::Bounds::fromPositions(pyramidVertices, 5, 8);
+        const rg::Bounds transparentBounds = rg::Bounds::fromPositions(transparentVertices, 6, 5);
+
+        rg::Scene scene;
+        const unsigned floorBatch = scene.addBatch(cubeBounds);
+        const unsigned pyramidBatch = scene.addBatch(pyramidBounds);
+        const unsigned tableTopCubeBatch = scene.addBatch(cubeBounds);
+        const unsigned sphereBatch = scene.addBatch(sphere.bounds);
+        const unsigned bookBatch = scene.addBatch(book.bounds);
+        const unsigned transparentBatch = scene.addBatch(transparentBounds);
+        const unsigned plantBatch = scene.addBatch(plant.bounds);
+        const unsigned lightCubeBatch = scene.addBatch(cubeBounds);
+
+        // everything on the table moves with it
+        const int tableNode = scene.add(glm::mat4(1.0f));
+        glm::mat4 model;
+
+        // floor and the four edges of the table
+        model = glm::mat4(1.0f);
+        model = glm::scale(model, glm::vec3(12.5f, 0.1f, 12.5f));
+        scene.add(model, floorBatch, tableNode);
+
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0, 0, 12.5f));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
         model = glm::scale(model, glm::vec3(12.5f, 0.1f, 1.0f));
-        floorShader.setMat4("model", model);
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        scene.add(model, floorBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0, 0, -12.5f));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
         model = glm::scale(model, glm::vec3(12.5f, 0.1f, 1.0f));
-        floorShader.setMat4("model", model);
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        scene.add(model, floorBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(12.5f, 0, 0));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0, 1, 0));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
         model = glm::scale(model, glm::vec3(12.5f, 0.1f, 1.0f));
-        floorShader.setMat4("model", model);
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        scene.add(model, floorBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-12.5f, 0, 0));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0, 1, 0));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1, 0, 0));
         model = glm::scale(model, glm::vec3(12.5f, 0.1f, 1.0f));
-        floorShader.setMat4("model", model);
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // transparent setup
+        scene.add(model, floorBatch, tableNode);
 
-        blendingShader.use();
-        model = glm::mat4(1.0f);
-        blendingShader.setMat4("projection", projection);
-        blendingShader.setMat4("view", view);
-        model = glm::translate(model, glm::vec3(6.8f, 2.4f, 9.0f));
-        model = glm::rotate(model, glm::radians(-70.0f), glm::vec3(0.0f, -1.0, 0.0f));
-        model = glm::scale(model, glm::vec3(2.7f));
-
-        blendingShader.setMat4("model", model);
-        glBindVertexArray(transparentVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        // Pyramid setup.
-
-        pyramidShader.use();
-        pyramidShader.setVec3("viewPos", lightPos);
-        pyramidShader.setFloat("material.shininess", 1.0f);
-        pyramidShader.setInt("flashLight", flashLight);
-
-        // light properties
-
-        pyramidShader.setVec3("dirLight.direction", glm::vec3(dirPos));
-        pyramidShader.setVec3("dirLight.ambient", 0.1f, 0.1f, 0.1f);
-        pyramidShader.setVec3("dirLight.diffuse", 0.2f, 0.2f, 0.2f);
-        pyramidShader.setVec3("dirLight.specular", 0.0f, 0.0f, 0.0f);
-
-        pyramidShader.setVec3("pointLight.position", lightPos);
-        pyramidShader.setVec3("pointLight.ambient", 0.1f, 0.1f, 0.05f);
-        pyramidShader.setVec3("pointLight.diffuse", 0.4f, 0.4f, 0.4f);
-        pyramidShader.setVec3("pointLight.specular", 0.6f, 0.6f, 0.6f);
-        pyramidShader.setFloat("pointLight.constant", 1.0f);
-        pyramidShader.setFloat("pointLight.linear", 0.07f);
-        pyramidShader.setFloat("pointLight.quadratic", 0.00002f);
-
-        pyramidShader.setVec3("spotLight.position", camera.Position);
-        pyramidShader.setVec3("spotLight.direction", camera.Front);
-        pyramidShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        pyramidShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        pyramidShader.setVec3("spotLight.specular", 0.8f, 0.8f, 0.8f);
-        pyramidShader.setFloat("spotLight.constant", 1.0f);
-        pyramidShader.setFloat("spotLight.linear", 0.007f);
-        pyramidShader.setFloat("spotLight.quadratic", 0.0002f);
-        pyramidShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        pyramidShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
 
+        // pyramids
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-9, 0.1f, 8.5f));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(-1.0f, 0.0, 0.0f));
         model = glm::scale(model, glm::vec3(3.0f));
-        pyramidShader.setMat4("model", model);
-        pyramidShader.setMat4("projection", projection);
-        pyramidShader.setMat4("view", view);
-
-        glBindVertexArray(pyramidVAO);
-        glDrawElements(GL_TRIANGLES, 18, GL_UNSIGNED_INT, 0);
+        scene.add(model, pyramidBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-9, 0.1f, 3.0f));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(-1.0f, 0.0, 0.0f));
         model = glm::scale(model, glm::vec3(2.5f));
-        pyramidShader.setMat4("model", model);
-
-        glBindVertexArray(pyramidVAO);
-        glDrawElements(GL_TRIANGLES, 18, GL_UNSIGNED_INT, 0);
+        scene.add(model, pyramidBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-6.7, 0.1f, 5.3));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(-1.0f, 0.0, 0.0f));
         model = glm::scale(model, glm::vec3(1.5f));
-        pyramidShader.setMat4("model", model);
-
-        glBindVertexArray(pyramidVAO);
-        glDrawElements(GL_TRIANGLES, 18, GL_UNSIGNED_INT, 0);
+        scene.add(model, pyramidBatch, tableNode);
 
-        // Table top cubes
-
-        tableTopCubeShader.use();
-        tableTopCubeShader.setVec3("viewPos", lightPos);
-        tableTopCubeShader.setFloat("material.shininess", 32.0f);
-        tableTopCubeShader.setInt("flashLight", flashLight);
-
-        // light properties
-
-        // directional light comes from the window of the skybox
-        // which is approximately (somewhere) behind the cubes, and is not as bright
-
-        tableTopCubeShader.setVec3("dirLight.direction", glm::vec3(dirPos));
-        tableTopCubeShader.setVec3("dirLight.ambient", 0.1f, 0.1f, 0.1f);
-        tableTopCubeShader.setVec3("dirLight.diffuse", 0.55f, 0.55f, 0.55f);
-        tableTopCubeShader.setVec3("dirLight.specular", 0.0f, 0.0f, 0.0f);
-
-        tableTopCubeShader.setVec3("pointLight.position", lightPos);
-        tableTopCubeShader.setVec3("pointLight.ambient", 0.05f, 0.05f, 0.05f);
-        tableTopCubeShader.setVec3("pointLight.diffuse", 1.0f, 1.0f, 1.0f);
-        tableTopCubeShader.setVec3("pointLight.specular", 0.3f, 0.3f, 0.3f);
-        tableTopCubeShader.setFloat("pointLight.constant", 1.0f);
-        tableTopCubeShader.setFloat("pointLight.linear", 0.007f);
-        tableTopCubeShader.setFloat("pointLight.quadratic", 0.0002f);
-
-        tableTopCubeShader.setVec3("spotLight.position", camera.Position);
-        tableTopCubeShader.setVec3("spotLight.direction", camera.Front);
-        tableTopCubeShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        tableTopCubeShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        tableTopCubeShader.setVec3("spotLight.specular", 0.3f, 0.3f, 0.3f);
-        tableTopCubeShader.setFloat("spotLight.constant", 1.0f);
-        tableTopCubeShader.setFloat("spotLight.linear", 0.007f);
-        tableTopCubeShader.setFloat("spotLight.quadratic", 0.0002f);
-        tableTopCubeShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(9.0f)));
-        tableTopCubeShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(12.0f)));
-
-        // cube 1
 
+        // table top cubes
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(9.0f, 2.1f, 9.0f));
         model = glm::rotate(model, glm::radians(-20.0f), glm::vec3(0.0, 1.0f, 0.0f));
         model = glm::scale(model, glm::vec3(2.0f));
-
-        tableTopCubeShader.setMat4("model", model);
-        tableTopCubeShader.setMat4("view", view);
-        tableTopCubeShader.setMat4("projection", projection);
-
-        glBindVertexArray(tableTopCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // cube 2
+        scene.add(model, tableTopCubeBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(9.0f, 1.6f, 3.0f));
         model = glm::rotate(model, glm::radians(20.0f), glm::vec3(0.0, 1.0f, 0.0f));
         model = glm::scale(model, glm::vec3(1.5f));
-        tableTopCubeShader.setMat4("model", model);
-        tableTopCubeShader.setMat4("view", view);
-        tableTopCubeShader.setMat4("projection", projection);
-
-        glBindVertexArray(tableTopCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // cube 3
+        scene.add(model, tableTopCubeBatch, tableNode);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(5.5f, 1.1f, 6.0f));
-        tableTopCubeShader.setMat4("model", model);
-        tableTopCubeShader.setMat4("view", view);
-        tableTopCubeShader.setMat4("projection", projection);
+        scene.add(model, tableTopCubeBatch, tableNode);
 
-        glBindVertexArray(tableTopCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // Models setup.
-
-        objectShader.use();
-        objectShader.setVec3("viewPos", lightPos);
-        objectShader.setFloat("material.shininess", 18.0f);
-        objectShader.setInt("flashLight", flashLight);
-
-        // light properties
-
-        objectShader.setVec3("dirLight.direction", glm::vec3(dirPos));
-        objectShader.setVec3("dirLight.ambient", 0.1f, 0.1f, 0.1f);
-        objectShader.setVec3("dirLight.diffuse", 0.2f, 0.2f, 0.2f);
-        objectShader.setVec3("dirLight.specular", 0.0f, 0.0f, 0.0f);
-
-        objectShader.setVec3("pointLight.position", lightPos);
-        objectShader.setVec3("pointLight.ambient", 0.05f, 0.05f, 0.05f);
-        objectShader.setVec3("pointLight.diffuse", 1.0f, 1.0f, 1.0f);
-        objectShader.setVec3("pointLight.specular", 0.0f, 0.0f, 0.0f);
-        objectShader.setFloat("pointLight.constant", 1.0f);
-        objectShader.setFloat("pointLight.linear", 0.007f);
-        objectShader.setFloat("pointLight.quadratic", 0.0002f);
-
-        objectShader.setVec3("spotLight.position", camera.Position);
-        objectShader.setVec3("spotLight.direction", camera.Front);
-        objectShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        objectShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        objectShader.setVec3("spotLight.specular", 1.2f, 1.2f, 1.2f);
-        objectShader.setFloat("spotLight.constant", 1.0f);
-        objectShader.setFloat("spotLight.linear", 0.007f);
-        objectShader.setFloat("spotLight.quadratic", 0.0002f);
-        objectShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        objectShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-
-        // sphere model
-
-        objectShader.setMat4("projection", projection);
-        objectShader.setMat4("view", view);
+        // the sphere
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(9.0f, -1.6f, -9.0f));
         model = glm::scale(model, glm::vec3(3.5f));
-        objectShader.setMat4("model", model);
-        sphere.Draw(objectShader);
-
-        // Plant model with normal mapping.
-
-        plantShader.use();
-        plantShader.setMat4("projection", projection);
-        plantShader.setMat4("view", view);
-
-        plantShader.setVec3("lightPos", lightPos);
-        plantShader.setVec3("viewPos", lightPos);
-        plantShader.setVec3("lightDir", dirPos);
-        plantShader.setInt("flashLight", flashLight);
-        plantShader.setFloat("material.shininess", 18.0f);
-
-        // Salju se vertex shader-u
-        plantShader.setVec3("spotPosition", camera.Position);
-        plantShader.setVec3("spotDirection", camera.Front);
-
-        plantShader.setVec3("dirLight.direction", glm::vec3(dirPos));
-        plantShader.setVec3("dirLight.ambient", 0.1f, 0.1f, 0.1f);
-        plantShader.setVec3("dirLight.diffuse", 0.2f, 0.2f, 0.2f);
-        plantShader.setVec3("dirLight.specular", glm::vec3(0.1f));
-
-        plantShader.setVec3("pointLight.position", lightPos);
-        plantShader.setVec3("pointLight.ambient", glm::vec3(0.1f));
-        plantShader.setVec3("pointLight.diffuse", 1.0f, 1.0f, 1.0f);
-        plantShader.setVec3("pointLight.specular", 0.0f, 0.0f, 0.0f);
-        plantShader.setFloat("pointLight.constant", 1.0f);
-        plantShader.setFloat("pointLight.linear", 0.007f);
-        plantShader.setFloat("pointLight.quadratic", 0.0002f);
-
-        // TODO: Da li ostaviti ovo (camera.*)?
-        plantShader.setVec3("spotLight.position", camera.Position);
-        plantShader.setVec3("spotLight.direction", camera.Front);
-        plantShader.setVec3("spotLight.ambient", glm::vec3(0.1f));
-        plantShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        plantShader.setVec3("spotLight.specular", glm::vec3(1.2f));
-        plantShader.setFloat("spotLight.constant", 1.0f);
-        plantShader.setFloat("spotLight.linear", 0.007f);
-        plantShader.setFloat("spotLight.quadratic", 0.0002f);
-        plantShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        plantShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-5.0f, 0.0f, -7.5f));
-        model = glm::scale(model, glm::vec3(0.3f));
-        plantShader.setMat4("model", model);
-        plant.Draw(plantShader);
-
-        // Book with parallax mapping
-
-        // TODO: prebaci na parallax occlusion metod
-        for (int i = 0; i < (int)book.meshes[0].textures.size(); i++) {
-            bookShader.setInt("material.texture_height1", book.meshes[0].textures.size());
-            glActiveTexture(GL_TEXTURE0 + book.meshes[0].textures.size());
-            glBindTexture(GL_TEXTURE_2D, heightMap);
-            bookShader.setFloat("heightScale", heightScale);
-        }
-
-        bookShader.use();
-        bookShader.setInt("flashLight", flashLight);
-        bookShader.setMat4("projection", projection);
-        bookShader.setMat4("view", view);
-        bookShader.setVec3("lightPos", lightPos);
-        bookShader.setVec3("lightDir", dirPos);
-        bookShader.setVec3("viewPos", lightPos);
-        bookShader.setFloat("material.shininess", 32.0f);
-
-        // Salju se vertex shader-u
-        bookShader.setVec3("spotPosition", camera.Position);
-        bookShader.setVec3("spotDirection", camera.Front);
-
-        bookShader.setVec3("dirLight.direction", glm::vec3(dirPos));
-        bookShader.setVec3("dirLight.ambient", glm::vec3(0.1));
-        bookShader.setVec3("dirLight.diffuse", 0.2f, 0.2f, 0.2f);
-        bookShader.setVec3("dirLight.specular", glm::vec3(0.1f));
-
-        bookShader.setVec3("pointLight.position", lightPos);
-        bookShader.setVec3("pointLight.ambient", glm::vec3(0.1f));
-        bookShader.setVec3("pointLight.diffuse", 1.0f, 1.0f, 1.0f);
-        bookShader.setVec3("pointLight.specular", glm::vec3(0.1));
-        bookShader.setFloat("pointLight.constant", 1.0f);
-        bookShader.setFloat("pointLight.linear", 0.007f);
-        bookShader.setFloat("pointLight.quadratic", 0.0002f);
-
-        // TODO: Da li ostaviti ovo (camera.*)?
-        bookShader.setVec3("spotLight.position", camera.Position);
-        bookShader.setVec3("spotLight.direction", camera.Front);
-        bookShader.setVec3("spotLight.ambient", glm::vec3(0.1f));
-        bookShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        bookShader.setVec3("spotLight.specular", glm::vec3(1.2f));
-        bookShader.setFloat("spotLight.constant", 1.0f);
-        bookShader.setFloat("spotLight.linear", 0.007f);
-        bookShader.setFloat("spotLight.quadratic", 0.0002f);
-        bookShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        bookShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
+        scene.add(model, sphereBatch, tableNode);
 
+        // books
         std::vector<std::pair<glm::vec3, float>> positions{
                 make_pair(glm::vec3(-9.0f, 0.5f, -6.0f), glm::radians(90.0f)),
                 make_pair(glm::vec3(-8.8f, 1.0f, -6.0f), glm::radians(90.0f)),
@@ -927,111 +692,421 @@ int main() {
             else
                 model = glm::rotate(model, positions[i].second, glm::vec3(1.0, 0.0, 0.0));
             model = glm::scale(model, glm::vec3(0.8f));
-            bookShader.setMat4("model", model);
-            book.Draw(bookShader);
+            scene.add(model, bookBatch, tableNode);
         }
 
-        // Lighting cube defining
+        // transparent quad
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(6.8f, 2.4f, 9.0f));
+        model = glm::rotate(model, glm::radians(-70.0f), glm::vec3(0.0f, -1.0, 0.0f));
+        model = glm::scale(model, glm::vec3(2.7f));
+        scene.add(model, transparentBatch, tableNode);
 
-        lightCubeShader.use();
-        lightCubeShader.setMat4("projection", projection);
-        lightCubeShader.setMat4("view", view);
+        // plant
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(-5.0f, 0.0f, -7.5f));
+        model = glm::scale(model, glm::vec3(0.3f));
+        scene.add(model, plantBatch, tableNode);
+
+        // lighting cube, placed in the world rather than on the table
         model = glm::mat4(1.0f);
         model = glm::translate(model, lightPos);
         model = glm::scale(model, glm::vec3(1.5f));
+        scene.add(model, lightCubeBatch);
+
+        // Instance buffers of the batches drawn through the INSTANCED programs, refilled
+        // from the scene whenever it changes. The sphere is a single instance so that it
+        // can share litShader with the rest.
+        rg::InstanceBuffer floorInstances;
+        rg::InstanceBuffer pyramidInstances;
+        rg::InstanceBuffer tableTopCubeInstances;
+        rg::InstanceBuffer sphereInstances;
+        rg::InstanceBuffer bookInstances;
+        floorInstances.attach(cubeVAO);
+        pyramidInstances.attach(pyramidVAO);
+        tableTopCubeInstances.attach(tableTopCubeVAO);
+        for (Mesh &mesh : sphere.meshes)
+            sphereInstances.attach(mesh.VAO);
+        for (Mesh &mesh : book.meshes)
+            bookInstances.attach(mesh.VAO);
+        std::vector<glm::mat4> lodSortedWorlds;
+        std::vector<GLsizei> sphereLodCounts, bookLodCounts;
+
+        lightCubeShader.use();
         lightCubeShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-        lightCubeShader.setMat4("model", model);
 
-        glBindVertexArray(lightCubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        // scripted runs must not see placeholder textures, interactive ones start right away
+        if (scripted)
+            rg::TextureLoader::instance().finish();
+
+        // lookups made while linking and setting up don't belong to any frame
+        rg::UniformTable::endFrame();
+        rg::GLCallCounter::endFrame();
+        rg::RenderState::endFrame();
+        rg::AllocationCounter::endFrame();
+
+        // every shot is taken with the MSAA path and with both bloom blurs
+        std::vector<rg::RegressionCapture::Shot> shots;
+        {
+            const std::pair<std::string, std::function<void()>> paths[] = {
+                    { "msaa", []() { AABloom = false; } },
+                    { "bloom_mips", []() { AABloom = true; bloom = true; bloomPyramid = true; } },
+                    { "bloom_blur", []() { AABloom = true; bloom = true; bloomPyramid = false; } }
+            };
+            const rg::RegressionCapture::Shot poses[] = {
+                    { "overview", glm::vec3(14.0f, 14.0f, 12.0f), glm::vec3(0.0f), nullptr },
+                    { "books", glm::vec3(-3.0f, 4.0f, -2.0f), glm::vec3(-8.5f, 0.8f, -5.0f), nullptr },
+                    { "pyramids", glm::vec3(-2.0f, 4.0f, 8.0f), glm::vec3(-8.0f, 0.5f, 5.5f), nullptr },
+                    { "cubes", glm::vec3(3.0f, 5.0f, 14.0f), glm::vec3(8.0f, 1.5f, 6.0f), nullptr },
+                    { "plant", glm::vec3(0.0f, 5.0f, -2.0f), glm::vec3(-5.0f, 1.0f, -7.5f), nullptr },
+                    { "light", glm::vec3(0.0f, 3.0f, 18.0f), lightPos, nullptr }
+            };
+            for (const auto &path : paths)
+                for (rg::RegressionCapture::Shot shot : poses) {
+                    shot.name += "_" + path.first;
+                    shot.setup = path.second;
+                    shots.push_back(shot);
+                }
+        }
+        rg::RegressionCapture regression(captureOptions, shots);
+        rg::FrameCapture frameCapture;
+
+        while (!glfwWindowShouldClose(window) && !(benchOptions.enabled && bench.finished())
+               && !(captureOptions.enabled && regression.finished())) {
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            bench.beginFrame();
+            if (scripted)
+                deltaTime = rg::Benchmark::DELTA_TIME;
+
+            // spinning cube
+            // the following two lines are commented out, but can be uncommented
+            // if you wish to see how the constant changing of the light position
+            // affects the lighting on objects
+
+    //        lightPos.x = 5*sin(currentFrame)+1;
+    //        lightPos.z = 5*cos(currentFrame)+1;
+
+            if (captureOptions.enabled)
+                regression.beginFrame(camera);
+            else if (benchOptions.enabled)
+                bench.placeCamera(camera);
+            else
+                processInput(window);
 
-        // skybox
+            // swap in the textures decoded since the last frame
+            rg::TextureLoader::instance().poll();
 
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-        skyboxShader.use();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix())); // remove translation from the view matrix
-        skyboxShader.setMat4("view", view);
-        skyboxShader.setMat4("projection", projection);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // render skybox cube
-        glBindVertexArray(skyboxVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS); // set depth function back to default
-
-        if(AABloom){
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            // blur bright fragments with two-pass Gaussian Blur
-            // --------------------------------------------------
-            bool horizontal = true, first_iteration = true;
-            unsigned int amount = 10;
-            shaderBlur.use();
-            for (unsigned int i = 0; i < amount; i++)
-            {
-                glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-                shaderBlur.setInt("horizontal", horizontal);
-                glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
+            // render scene into floating point framebuffer
+            // -----------------------------------------------BLOOM
+
+            resolutionController.setEnabled(dynamicResolution);
+            resolutionController.beginFrame();
+            profiler.beginFrame();
+            const int scenePass = profiler.begin("scene");
+            renderTargets.setOutputSize(framebufferWidth, framebufferHeight);
+            renderTargets.setRenderScale(resolutionController.scale());
+            renderTargets.beginFrame();
+
+            unsigned int sceneColor, brightColor = 0, sceneDepth;
+            if(AABloom){
+                // 1 color buffer for normal rendering, the other for brightness threshold values
+                sceneColor = renderTargets.acquire(hdrFormat);
+                brightColor = renderTargets.acquire(hdrFormat);
+                sceneDepth = renderTargets.acquire(rg::TargetFormat::texture(GL_DEPTH_COMPONENT24));
+                glBindFramebuffer(GL_FRAMEBUFFER, renderTargets.framebuffer({ sceneColor, brightColor }, sceneDepth));
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glEnable(GL_DEPTH_TEST);
+            }else{
+                // 1. draw scene as normal in multisampled buffers
+                sceneColor = renderTargets.acquire(rg::TargetFormat::multisampled(GL_RGB8, 4));
+                sceneDepth = renderTargets.acquire(rg::TargetFormat::multisampled(GL_DEPTH24_STENCIL8, 4));
+                glBindFramebuffer(GL_FRAMEBUFFER, renderTargets.framebuffer({ sceneColor }, sceneDepth));
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glEnable(GL_DEPTH_TEST);
+            }
+            glViewport(0, 0, renderTargets.width(), renderTargets.height());
+
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)renderTargets.outputWidth() / (float)renderTargets.outputHeight(), 0.1f, 100.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+
+            // one upload of everything the shaders share this frame
+            rg::FrameData frameData;
+            frameData.projection = projection;
+            frameData.view = view;
+            frameData.viewPos = glm::vec4(lightPos, 1.0f);
+
+            rg::LightData lightData;
+            lightData.dirLightDirection = glm::vec4(dirPos, 0.0f);
+            lightData.pointLightPosition = glm::vec4(lightPos, 1.0f);
+            lightData.spotLightPosition = glm::vec4(camera.Position, 1.0f);
+            lightData.spotLightDirection = camera.Front;
+            lightData.flashLight = flashLight;
+
+            frameUniforms.update(frameData, lightData);
+
+            // only what intersects the view frustum ends up in the instance buffers
+            const rg::Frustum frustum(projection * view);
+            if (scene.update(frustum)) {
+                floorInstances.update(scene.batchWorlds(floorBatch), scene.batch(floorBatch).count);
+                pyramidInstances.update(scene.batchWorlds(pyramidBatch), scene.batch(pyramidBatch).count);
+                tableTopCubeInstances.update(scene.batchWorlds(tableTopCubeBatch), scene.batch(tableTopCubeBatch).count);
+            }
+
+            // Models pick their level of detail by projected size; the instances of the book
+            // and sphere batches move between levels with the camera, so they are sorted by
+            // level and uploaded every frame.
+            const rg::LodSelector lodSelector(camera.Position, glm::radians(camera.Zoom), (float)renderTargets.outputHeight());
+            sphere.sortInstancesByLod(lodSelector, scene.batchWorlds(sphereBatch), scene.batch(sphereBatch).count, lodSortedWorlds, sphereLodCounts);
+            sphereInstances.update(lodSortedWorlds);
+            book.sortInstancesByLod(lodSelector, scene.batchWorlds(bookBatch), scene.batch(bookBatch).count, lodSortedWorlds, bookLodCounts);
+            bookInstances.update(lodSortedWorlds);
+
+            // Objects sharing litShader, drawn together. Textures are bound where they are used,
+            // rg::RenderState drops the binds of units that still hold them.
+            litShader.use();
+            woodTexture.bind();
+            pyramidTexture.bind();
+            tableTopCubeTexture.bind();
+
+            // Floor and edges of the table.
+            materials.apply(floorMaterial, litSamplers);
+            glBindVertexArray(cubeVAO);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, floorInstances.count());
+
+            // Pyramid setup.
+            materials.apply(pyramidMaterial, litSamplers);
+            glBindVertexArray(pyramidVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, 18, GL_UNSIGNED_INT, 0, pyramidInstances.count());
+
+            // Table top cubes
+            materials.apply(tableTopCubeMaterial, litSamplers);
+            glBindVertexArray(tableTopCubeVAO);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, tableTopCubeInstances.count());
+
+            // sphere model
+            materials.apply(sphereMaterial, litSamplers);
+            sphere.DrawInstanced(litShader, sphereInstances, sphereLodCounts);
+
+            // transparent setup
+
+            blendingShader.use();
+            transparentTexture.bind();
+            glBindVertexArray(transparentVAO);
+            for (unsigned i = 0; i < scene.batch(transparentBatch).count; i++) {
+                blendingShader.setMat4(blendingShaderModelLoc, scene.batchWorlds(transparentBatch)[i]);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+
+            // Plant model with normal mapping.
+
+            plantShader.use();
+            materials.bind(plantMaterial.block);
+
+            for (unsigned i = 0; i < scene.batch(plantBatch).count; i++) {
+                plantShader.setMat4(plantShaderModelLoc, scene.batchWorlds(plantBatch)[i]);
+                plant.Draw(plantShader, frustum, scene.batchWorlds(plantBatch)[i], &lodSelector);
+            }
+
+            // Book with parallax mapping
+
+            // TODO: prebaci na parallax occlusion metod
+            bookShader.use();
+            materials.bind(bookMaterial.block);
+            // rebound every frame, other draws reuse the unit; rg::RenderState drops the call
+            // while it still holds the height map
+            glActiveTexture(GL_TEXTURE0 + book.meshes[0].textures.size());
+            glBindTexture(GL_TEXTURE_2D, heightMap);
+            bookShader.setFloat("heightScale", heightScale);
+
+            book.DrawInstanced(bookShader, bookInstances, bookLodCounts);
+
+            // Lighting cube defining
+
+            lightCubeShader.use();
+            glBindVertexArray(lightCubeVAO);
+            for (unsigned i = 0; i < scene.batch(lightCubeBatch).count; i++) {
+                lightCubeShader.setMat4(lightCubeShaderModelLoc, scene.batchWorlds(lightCubeBatch)[i]);
+                glDrawArrays(GL_TRIANGLES, 0, 36);
+            }
+
+            // skybox
+
+            glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+            skyboxShader.use(); // the shader removes the translation from the shared view matrix
+            skyboxTexture.bindCubemap();
+
+            // render skybox cube
+            glBindVertexArray(skyboxVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glBindVertexArray(0);
+            glDepthFunc(GL_LESS); // set depth function back to default
+            profiler.end(scenePass);
+
+            if(AABloom){
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                renderTargets.release(sceneDepth);
+                unsigned int bloomTexture;
+                float bloomStrength;
+                if (bloomPyramid) {
+                    // blur bright fragments through the mip chain, every level adds to the glow
+                    rg::Profiler::Scope pass(profiler, "bloom mips");
+                    bloomTexture = bloomMips.render(brightColor, renderTargets);
+                    bloomStrength = 1.0f / bloomMips.levels();
+                    renderTargets.release(brightColor);
+                } else {
+                    // blur bright fragments with two-pass Gaussian Blur, ping-ponging between the
+                    // brightness buffer, which isn't needed after the first pass, and one more target
+                    // --------------------------------------------------
+                    rg::Profiler::Scope pass(profiler, "blur");
+                    unsigned int pingpongColorbuffers[2] = { brightColor, renderTargets.acquire(hdrFormat) };
+                    unsigned int source = 0;
+                    unsigned int amount = 10;
+                    shaderBlur.use();
+                    if (blurRadiusChanged) {
+                        rg::GaussianKernel(blurRadius, blurRadius / 2.5f).upload(shaderBlur);
+                        blurRadiusChanged = false;
+                    }
+                    glActiveTexture(GL_TEXTURE0);
+                    for (unsigned int i = 0; i < amount; i++)
+                    {
+                        glBindFramebuffer(GL_FRAMEBUFFER, renderTargets.framebuffer({ pingpongColorbuffers[!source] }));
+                        shaderBlur.setInt("horizontal", i % 2 == 0);
+                        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[source]);
+                        renderQuad();
+                        source = !source;
+                    }
+                    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                    bloomTexture = pingpongColorbuffers[source];
+                    bloomStrength = 1.0f;
+                    renderTargets.release(pingpongColorbuffers[!source]);
+                }
+
+                // now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
+                // the internal resolution is scaled up to the window here
+                // --------------------------------------------------------------------------------------------------------------------------
+                const int compositePass = profiler.begin("bloom composite");
+                glViewport(0, 0, renderTargets.outputWidth(), renderTargets.outputHeight());
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                shaderBloomFinal.use();
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, sceneColor);
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, bloomTexture);
+                shaderBloomFinal.setInt("bloom", bloom);
+                shaderBloomFinal.setFloat("bloomStrength", bloomStrength);
+                shaderBloomFinal.setFloat("exposure", exposure);
                 renderQuad();
-                horizontal = !horizontal;
-                if (first_iteration)
-                    first_iteration = false;
+                profiler.end(compositePass);
+                renderTargets.release(sceneColor);
+                renderTargets.release(bloomTexture);
+            }else{
+                // 2. now blit multisampled buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
+                const int resolvePass = profiler.begin("msaa resolve");
+                unsigned int screenTexture = renderTargets.acquire(rg::TargetFormat::texture(GL_RGB8));
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, renderTargets.framebuffer({ sceneColor }, sceneDepth));
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, renderTargets.framebuffer({ screenTexture }));
+                glBlitFramebuffer(0, 0, renderTargets.width(), renderTargets.height(), 0, 0, renderTargets.width(), renderTargets.height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                renderTargets.release(sceneColor);
+                renderTargets.release(sceneDepth);
+                profiler.end(resolvePass);
+
+                // 3. now render quad with scene's visuals as its texture image, scaled up to the window
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, renderTargets.outputWidth(), renderTargets.outputHeight());
+                glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glDisable(GL_DEPTH_TEST);
+
+                // draw Screen quad
+                const int screenPass = profiler.begin("screen quad");
+                screenShader.use();
+                glBindVertexArray(quadVAO);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, screenTexture); // use the now resolved color attachment as the quad's texture
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                profiler.end(screenPass);
+                renderTargets.release(screenTexture);
             }
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-            // now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
-            // --------------------------------------------------------------------------------------------------------------------------
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            shaderBloomFinal.use();
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-            shaderBloomFinal.setInt("bloom", bloom);
-            shaderBloomFinal.setFloat("exposure", exposure);
-            renderQuad();
-        }else{
-            // 2. now blit multisampled buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
-            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-            // 3. now render quad with scene's visuals as its texture image
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            glDisable(GL_DEPTH_TEST);
-
-            // draw Screen quad
-            screenShader.use();
-            glBindVertexArray(quadVAO);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, screenTexture); // use the now resolved color attachment as the quad's texture
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            if (showProfiler) {
+                rg::Profiler::Scope pass(profiler, "imgui");
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+                profiler.drawOverlay();
+                ImGui::Render();
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
+            if (dumpProfile) {
+                dumpProfile = false;
+                if (profiler.writeCsv("profile.csv"))
+                    std::cerr << "profile written to profile.csv\n";
+                else
+                    std::cerr << "could not write profile.csv\n";
+            }
+
+            resolutionController.endFrame();
+            lastGpuMilliseconds = resolutionController.gpuMilliseconds();
+            lastRenderScale = renderTargets.renderScale();
+
+            lastFrameLookups = rg::UniformTable::endFrame();
+            lastFrameCulling = rg::Frustum::endFrame();
+            lastFrameLods = rg::LodSelector::endFrame();
+
+            if (captureOptions.enabled)
+                regression.endFrame(frameCapture, framebufferWidth, framebufferHeight);
+
+            glfwSwapBuffers(window);
+            lastFrameCalls = rg::GLCallCounter::endFrame();
+            lastFrameState = rg::RenderState::endFrame();
+            bench.endFrame(lastFrameCalls, lastFrameState);
+            glfwPollEvents();
+            lastFrameAllocations = rg::AllocationCounter::endFrame();
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
+        if (benchOptions.enabled) {
+            if (bench.writeReport(profiler, framebufferWidth, framebufferHeight))
+                std::cerr << "benchmark report written to " << benchOptions.report << "\n";
+            else
+                std::cerr << "could not write " << benchOptions.report << "\n";
+        }
+        capturesMatch = !captureOptions.enabled || regression.finish(frameCapture);
 
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &pyramidVAO);
+        glDeleteVertexArrays(1, &cubeVAO);
+        glDeleteVertexArrays(1, &pyramidVAO);
 
-    glDeleteBuffers(1, &cubeVBO);
-    glDeleteBuffers(1, &pyramidVBO);
-    glDeleteBuffers(1, &pyramidEBO);
+        glDeleteBuffers(1, &cubeVBO);
+        glDeleteBuffers(1, &pyramidVBO);
+        glDeleteBuffers(1, &pyramidEBO);
 
-    glDeleteVertexArrays(1, &tableTopCubeVAO);
-    glDeleteBuffers(1, &tableTopCubeVBO);
-    glDeleteVertexArrays(1, &lightCubeVAO);
+        glDeleteVertexArrays(1, &tableTopCubeVAO);
+        glDeleteBuffers(1, &tableTopCubeVBO);
+        glDeleteVertexArrays(1, &lightCubeVAO);
 
-    glDeleteBuffers(1, &transparentVBO);
-    glDeleteVertexArrays(1, &transparentVAO);
+        glDeleteBuffers(1, &transparentVBO);
+        glDeleteVertexArrays(1, &transparentVAO);
 
-    glDeleteVertexArrays(1, &skyboxVAO);
-    glDeleteBuffers(1, &skyboxVBO);
+        glDeleteVertexArrays(1, &skyboxVAO);
+        glDeleteBuffers(1, &skyboxVBO);
+        rg::TextureCache::instance().release(heightMap);
+    }
+    // textures nothing holds any more and the loader's staging buffers go with the context
+    rg::TextureCache::instance().evictUnreferenced();
+    rg::TextureLoader::instance().shutdown();
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
 
     glfwTerminate();
-    return 0;
+    return capturesMatch ? 0 : 1;
 }
 
 // renderQuad() renders a 1x1 XY quad in NDC
@@ -1135,6 +1210,53 @@ void processInput(GLFWwindow *window) {
     {
         AABloomKeyPressed = false;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !bloomPyramidKeyPressed)
+    {
+        bloomPyramid = !bloomPyramid;
+        bloomPyramidKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+    {
+        bloomPyramidKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !showProfilerKeyPressed)
+    {
+        showProfiler = !showProfiler;
+        showProfilerKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE)
+    {
+        showProfilerKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !dynamicResolutionKeyPressed)
+    {
+        dynamicResolution = !dynamicResolution;
+        dynamicResolutionKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE)
+    {
+        dynamicResolutionKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS && !blurRadiusKeyPressed)
+    {
+        blurRadius = std::min(blurRadius + 1, int(rg::GaussianKernel::MAX_RADIUS));
+        blurRadiusChanged = true;
+        blurRadiusKeyPressed = true;
+    }
+    else if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS && !blurRadiusKeyPressed)
+    {
+        blurRadius = std::max(blurRadius - 1, 1);
+        blurRadiusChanged = true;
+        blurRadiusKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_RELEASE)
+    {
+        blurRadiusKeyPressed = false;
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -1142,7 +1264,10 @@ void processInput(GLFWwindow *window) {
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
+    // The offscreen targets follow on the next frame.
     glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -1190,41 +1315,32 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 
 
     }
+
+    if (key == GLFW_KEY_O && action == GLFW_PRESS)
+        dumpProfile = true;
+
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        std::cerr << "uniform lookups last frame: " << lastFrameLookups.driverLookups << " driver, "
+                  << lastFrameLookups.tableLookups << " cached\n";
+        std::cerr << "objects last frame: " << lastFrameCulling.drawn << " drawn, "
+                  << lastFrameCulling.culled << " culled\n";
+        std::cerr << "triangles last frame: " << lastFrameLods.triangles << " drawn, "
+                  << lastFrameLods.fullTriangles << " at full detail\n";
+        std::cerr << "gl calls last frame: " << lastFrameCalls.drawCalls << " draws, "
+                  << lastFrameCalls.stateChanges << " state changes, " << lastFrameState.elided << " of "
+                  << lastFrameState.calls << " tracked state calls elided\n";
+        std::cerr << "heap allocations last frame: " << lastFrameAllocations.allocations << " ("
+                  << lastFrameAllocations.bytes << " bytes), " << lastFrameAllocations.drawAllocations << " drawing models\n";
+        rg::TextureCacheStats textureCache = rg::TextureCache::instance().stats();
+        std::cerr << "texture cache: " << textureCache.textures << " textures (" << textureCache.unreferenced << " unreferenced), "
+                  << textureCache.residentBytes / 1024 << " KiB, " << textureCache.hits << " hits, " << textureCache.misses << " misses\n";
+        std::cerr << "gpu frame time: " << lastGpuMilliseconds << " ms, render scale " << lastRenderScale << "\n";
+    }
 }
 
 unsigned int loadTexture(char const * path)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    // decoded on the texture loader's threads, uploaded by TextureLoader::poll; shared with
+    // the models that use the same file
+    return rg::TextureCache::instance().acquire2D(path);
 }
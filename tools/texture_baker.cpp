@@ -0,0 +1,215 @@
+// Bakes images into .rgtx files with a full, block compressed mip chain, so the renderer
+// can map them and upload the levels directly instead of decoding and generating mipmaps.
+//
+//     texture_baker [--force] <image or directory>...
+//
+// Directories are searched recursively for .jpg, .jpeg and .png files. Every image gets
+// <image>.rgtx next to it; images whose baked file is newer and of the current version are
+// skipped unless --force. Tangent space normal maps, named *normal* or *nrm*, keep only
+// x and y in BC5; the shaders rebuild z.
+
+#include <stb_image.h>
+#include <rg/BlockCompression.h>
+#include <rg/MappedFile.h>
+#include <rg/TextureContainer.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool hasImageExtension(const std::string &path)
+{
+    std::size_t dot = path.rfind('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == "jpg" || extension == "jpeg" || extension == "png";
+}
+
+bool isNormalMap(const std::string &path)
+{
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    return name.find("normal") != std::string::npos || name.find("nrm") != std::string::npos;
+}
+
+// averaging shortens the normals of a level, scale them back to unit length
+void renormalize(std::vector<unsigned char> &rgba)
+{
+    for (std::size_t i = 0; i < rgba.size(); i += 4) {
+        float n[3], length = 0.0f;
+        for (int c = 0; c < 3; c++) {
+            n[c] = rgba[i + c] / 127.5f - 1.0f;
+            length += n[c] * n[c];
+        }
+        length = std::sqrt(length);
+        if (length == 0.0f)
+            continue;
+        for (int c = 0; c < 3; c++)
+            rgba[i + c] = static_cast<unsigned char>(std::lround((n[c] / length + 1.0f) * 127.5f));
+    }
+}
+
+// baked after the image was last changed, by this version of the baker
+bool upToDate(const std::string &image)
+{
+    std::string baked = rg::rgtx::bakedPath(image);
+    if (rg::MappedFile::modificationTime(baked) < rg::MappedFile::modificationTime(image))
+        return false;
+    rg::MappedFile file(baked);
+    rg::rgtx::Header header;
+    std::vector<rg::rgtx::Level> levels;
+    return file.valid() && rg::rgtx::parse(file.data(), file.size(), header, levels);
+}
+
+void collectImages(const std::string &path, std::vector<std::string> &images)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        std::cerr << "no such file or directory: " << path << "\n";
+        return;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        if (hasImageExtension(path))
+            images.push_back(path);
+        return;
+    }
+
+    DIR *directory = opendir(path.c_str());
+    if (!directory)
+        return;
+    std::vector<std::string> entries;
+    while (dirent *entry = readdir(directory))
+        if (entry->d_name[0] != '.')
+            entries.push_back(path + "/" + entry->d_name);
+    closedir(directory);
+
+    std::sort(entries.begin(), entries.end());
+    for (const std::string &entry : entries)
+        collectImages(entry, images);
+}
+
+bool bake(const std::string &path)
+{
+    int width, height, components;
+    unsigned char *data = stbi_load(path.c_str(), &width, &height, &components, 4);
+    if (!data) {
+        std::cerr << path << ": " << stbi_failure_reason() << "\n";
+        return false;
+    }
+    std::vector<unsigned char> rgba(data, data + static_cast<std::size_t>(width) * height * 4);
+    stbi_image_free(data);
+
+    // single channel images (height maps) keep one channel, normal maps two, the rest keep
+    // alpha only if used
+    std::uint32_t codec = rg::rgtx::BC1;
+    if (components == 1)
+        codec = rg::rgtx::BC4;
+    else if (isNormalMap(path))
+        codec = rg::rgtx::BC5;
+    else if (components == 4)
+        for (std::size_t i = 3; i < rgba.size(); i += 4)
+            if (rgba[i] != 255) {
+                codec = rg::rgtx::BC3;
+                break;
+            }
+
+    std::vector<rg::rgtx::Level> levels;
+    std::vector<unsigned char> payload;
+    int levelWidth = width, levelHeight = height;
+    for (;;) {
+        rg::rgtx::Level level;
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.size = rg::rgtx::levelBytes(codec, levelWidth, levelHeight);
+        level.offset = payload.size();
+        payload.resize(payload.size() + level.size);
+
+        unsigned char *out = payload.data() + level.offset;
+        for (int by = 0; by < (levelHeight + 3) / 4; by++)
+            for (int bx = 0; bx < (levelWidth + 3) / 4; bx++) {
+                rg::bc::Block block = rg::bc::fetchBlock(rgba.data(), levelWidth, levelHeight, bx, by);
+                if (codec == rg::rgtx::BC1)
+                    rg::bc::encodeBC1(block, out);
+                else if (codec == rg::rgtx::BC3)
+                    rg::bc::encodeBC3(block, out);
+                else if (codec == rg::rgtx::BC5)
+                    rg::bc::encodeBC5(block, out);
+                else
+                    rg::bc::encodeBC4(block, out);
+                out += rg::rgtx::blockBytes(codec);
+            }
+        levels.push_back(level);
+
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        rgba = rg::bc::downsample(rgba, levelWidth, levelHeight, levelWidth, levelHeight);
+        if (codec == rg::rgtx::BC5)
+            renormalize(rgba);
+    }
+
+    rg::rgtx::Header header;
+    std::memcpy(header.magic, rg::rgtx::MAGIC, 4);
+    header.version = rg::rgtx::VERSION;
+    header.codec = codec;
+    header.width = width;
+    header.height = height;
+    header.levels = static_cast<std::uint32_t>(levels.size());
+
+    std::size_t dataStart = sizeof(header) + levels.size() * sizeof(rg::rgtx::Level);
+    for (rg::rgtx::Level &level : levels)
+        level.offset += dataStart;
+
+    std::string output = rg::rgtx::bakedPath(path);
+    std::ofstream file(output, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(rg::rgtx::Level));
+    file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    if (!file) {
+        std::cerr << output << ": write failed\n";
+        return false;
+    }
+
+    const char *codecNames[] = { "", "BC1", "BC3", "BC4", "BC5" };
+    std::size_t sourceBytes = static_cast<std::size_t>(width) * height * std::max(components, 3) * 4 / 3;
+    std::cout << output << ": " << width << "x" << height << " " << codecNames[codec] << ", " << levels.size()
+              << " levels, " << payload.size() / 1024 << " KiB (" << sourceBytes / 1024 << " KiB uncompressed)\n";
+    return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    bool force = false;
+    std::vector<std::string> images;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--force") == 0)
+            force = true;
+        else
+            collectImages(argv[i], images);
+    }
+    if (images.empty()) {
+        std::cerr << "usage: texture_baker [--force] <image or directory>...\n";
+        return 1;
+    }
+
+    int failures = 0;
+    for (const std::string &image : images) {
+        if (!force && upToDate(image))
+            continue;
+        if (!bake(image))
+            failures++;
+    }
+    return failures ? 1 : 0;
+}